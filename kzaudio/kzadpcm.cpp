@@ -0,0 +1,196 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzadpcm.cpp													          |
+| Desc: block decoders for IMA4 and Microsoft ADPCM                           |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#include "kzadpcm.h"
+namespace kz {
+
+#define IMA4_NUMSTEPS    89
+#define IMA4_HEADERSIZE  4
+#define MSADPCM_HEADERSIZE 7
+
+
+
+	const Int16 MSADPCM_COEFS[MSADPCM_NUMCOEFS * 2] = {
+		256, 0, 512, -256, 0, 0, 192, 64, 240, 0, 460, -208, 392, -232
+	};
+
+
+
+	static const Int32 IMA4_STEPS[IMA4_NUMSTEPS] = {
+		7,     8,     9,     10,    11,    12,    13,    14,    16,
+		17,    19,    21,    23,    25,    28,    31,    34,    37,
+		41,    45,    50,    55,    60,    66,    73,    80,    88,
+		97,    107,   118,   130,   143,   157,   173,   190,   209,
+		230,   253,   279,   307,   337,   371,   408,   449,   494,
+		544,   598,   658,   724,   796,   876,   963,   1060,  1166,
+		1282,  1411,  1552,  1707,  1878,  2066,  2272,  2499,  2749,
+		3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,
+		7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899, 15289,
+		16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+	};
+
+	static const Int32 IMA4_INDICES[16] = {
+		-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+	};
+
+	static const Int32 MSADPCM_ADAPT[16] = {
+		230, 230, 230, 230, 307, 409, 512, 614,
+		768, 614, 512, 409, 307, 230, 230, 230
+	};
+
+
+
+	/**
+	difference and next step index for every step index and nibble,
+	so decoding a nibble is two lookups instead of the bit tests*/
+	struct IMA4Table {
+		Int32 diff[IMA4_NUMSTEPS][16];
+		Uint8 next[IMA4_NUMSTEPS][16];
+
+		IMA4Table() {
+			for (Int32 index = 0; index < IMA4_NUMSTEPS; ++index) {
+				const Int32 step = IMA4_STEPS[index];
+				for (Int32 nibble = 0; nibble < 16; ++nibble) {
+					Int32 delta = step >> 3;
+					if (nibble & 1) delta += step >> 2;
+					if (nibble & 2) delta += step >> 1;
+					if (nibble & 4) delta += step;
+					diff[index][nibble] = (nibble & 8) ? -delta : delta;
+					next[index][nibble] = (Uint8)(Max(0, Min(
+						index + IMA4_INDICES[nibble], IMA4_NUMSTEPS - 1)));
+				}
+			}
+		}
+	};
+
+
+
+	static const IMA4Table& GetIMA4Table() {
+		static const IMA4Table table;
+		return table;
+	}
+
+
+
+	static inline Int16 ReadInt16(const Byte* bytes) {
+		return (Int16)(bytes[0] | (bytes[1] << 0x8));
+	}
+
+
+
+	static inline Int16 ClampSample(Int32 sample) {
+		return (Int16)(Max(-32768, Min(sample, 32767)));
+	}
+
+
+
+	Uint32 GetFramesIMA4(Uint32 nbytes, Uint32 nchannels) {
+		const Uint32 header = IMA4_HEADERSIZE * nchannels;
+		if (nchannels == 0 || nbytes < header)
+			return 0;
+		//every 4 bytes per channel hold 8 frames
+		return 1 + (nbytes - header) / (4 * nchannels) * 8;
+	}
+
+
+
+	Uint32 GetFramesMSADPCM(Uint32 nbytes, Uint32 nchannels) {
+		const Uint32 header = MSADPCM_HEADERSIZE * nchannels;
+		if (nchannels == 0 || nbytes < header)
+			return 0;
+		return 2 + (nbytes - header) * 2 / nchannels;
+	}
+
+
+
+	Void DecodeIMA4(const Byte* block, Uint32 nchannels,
+		Uint32 nframes, Int16* dest) {
+		const IMA4Table& table = GetIMA4Table();
+		if (nframes == 0) {
+			return;
+		}
+		for (Uint32 c = 0; c < nchannels; ++c) {
+			const Byte* header = block + c * IMA4_HEADERSIZE;
+			Int32 sample = ReadInt16(header);
+			Int32 index  = Min<Int32>(header[2], IMA4_NUMSTEPS - 1);
+			const Byte* data = block + nchannels * IMA4_HEADERSIZE + c * 4;
+
+			dest[c] = (Int16)(sample);
+			//each group of 8 frames is 4 bytes per channel, low nibble first
+			for (Uint32 frame = 1; frame < nframes; frame += 8) {
+				const Uint32 count = Min<Uint32>(8, nframes - frame);
+				Int16* out = dest + frame * nchannels + c;
+				for (Uint32 i = 0; i < count; ++i) {
+					const Int32 nibble = (data[i >> 1] >> ((i & 1) << 2)) & 0xF;
+					sample = ClampSample(sample + table.diff[index][nibble]);
+					index  = table.next[index][nibble];
+					out[i * nchannels] = (Int16)(sample);
+				}
+				data += 4 * nchannels;
+			}
+		}
+	}
+
+
+
+	Bool DecodeMSADPCM(const Byte* block, Uint32 nchannels,
+		Uint32 nframes, const Int16* coefs, Uint32 ncoefs, Int16* dest) {
+		Int32 coef1[2], coef2[2], delta[2], sample1[2], sample2[2];
+		if (nchannels == 0 || nchannels > 2) {
+			return false;
+		}
+		for (Uint32 c = 0; c < nchannels; ++c) {
+			const Uint32 predictor = block[c];
+			if (predictor >= ncoefs) {
+				return false;
+			}
+			coef1[c]   = coefs[predictor * 2];
+			coef2[c]   = coefs[predictor * 2 + 1];
+			delta[c]   = ReadInt16(block + nchannels + c * 2);
+			sample1[c] = ReadInt16(block + nchannels * 3 + c * 2);
+			sample2[c] = ReadInt16(block + nchannels * 5 + c * 2);
+		}
+		const Byte* data = block + nchannels * MSADPCM_HEADERSIZE;
+		Uint32 frame = 0;
+
+		//the header holds the first two frames, oldest first
+		for (; frame < Min<Uint32>(nframes, 2); ++frame) {
+			for (Uint32 c = 0; c < nchannels; ++c) {
+				*dest++ = (Int16)(frame == 0 ? sample2[c] : sample1[c]);
+			}
+		}
+		//nibbles alternate between the channels, high nibble first
+		for (Uint32 i = 0, count = (nframes - frame) * nchannels; i < count; ++i) {
+			const Uint32 c      = (nchannels == 2) ? (i & 1) : 0;
+			const Int32  nibble = (data[i >> 1] >> ((i & 1) ? 0 : 4)) & 0xF;
+			const Int32  signedNibble = (nibble & 8) ? nibble - 16 : nibble;
+			const Int32  predicted = (sample1[c] * coef1[c] + sample2[c] * coef2[c]) >> 8;
+
+			sample2[c] = sample1[c];
+			sample1[c] = ClampSample(predicted + signedNibble * delta[c]);
+			delta[c]   = Max((MSADPCM_ADAPT[nibble] * delta[c]) >> 8, 16);
+			*dest++    = (Int16)(sample1[c]);
+		}
+		return true;
+	}
+};
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/
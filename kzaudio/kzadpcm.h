@@ -0,0 +1,65 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzadpcm.h													          |
+| Desc: block decoders for IMA4 and Microsoft ADPCM                           |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#ifndef __KZADPCM_H__
+#define __KZADPCM_H__
+
+#include "kzbasetypes.h"
+namespace kz {
+
+
+
+	/** number of coefficient pairs in the standard MS-ADPCM table*/
+	enum { MSADPCM_NUMCOEFS = 7 };
+
+	/** the standard MS-ADPCM predictor coefficients (pairs)*/
+	extern const Int16 MSADPCM_COEFS[MSADPCM_NUMCOEFS * 2];
+
+
+	/** returns the number of frames in an IMA4 block of the given size*/
+	extern Uint32 GetFramesIMA4(Uint32 nbytes, Uint32 nchannels);
+
+	/** returns the number of frames in an MS-ADPCM block of the given size*/
+	extern Uint32 GetFramesMSADPCM(Uint32 nbytes, Uint32 nchannels);
+
+
+	/** decode one block of WAV/IMA4 ADPCM to interleaved 16-bit samples
+		@param block:     the encoded block
+		@param nchannels: channels interleaved in the block
+		@param nframes:   frames to decode, at most the block's frame count
+		@param dest:      receives nframes * nchannels samples*/
+	extern Void DecodeIMA4(const Byte* block, Uint32 nchannels,
+		Uint32 nframes, Int16* dest);
+
+
+	/** decode one block of Microsoft ADPCM to interleaved 16-bit samples
+		@param block:     the encoded block
+		@param nchannels: channels interleaved in the block
+		@param nframes:   frames to decode, at most the block's frame count
+		@param coefs:     predictor coefficient pairs
+		@param ncoefs:    number of coefficient pairs
+		@param dest:      receives nframes * nchannels samples
+		@return:          false if the block uses an unknown predictor*/
+	extern Bool DecodeMSADPCM(const Byte* block, Uint32 nchannels,
+		Uint32 nframes, const Int16* coefs, Uint32 ncoefs, Int16* dest);
+};
+/*****************************************************************************/
+#endif//EOF                                                                   |
+/*****************************************************************************/
@@ -0,0 +1,157 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzallocator.cpp												          |
+| Desc: allocator interface and scratch arenas                                |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#if defined(_WIN32)
+#  include <malloc.h>
+#endif
+#include "kzallocator.h"
+namespace kz {
+
+#define ARENA_HEADERSIZE \
+	((sizeof(ScratchArena::Block) + KZALLOCATOR_ALIGNMENT - 1) & ~(SizeT)(KZALLOCATOR_ALIGNMENT - 1))
+
+
+	/**
+	allocator over the c runtime heap*/
+	class HeapAllocator final : public Allocator {
+	public:
+		Lpvoid Allocate(SizeT nbytes, SizeT alignment) override {
+		#if defined(_WIN32)
+			return _aligned_malloc(Max<SizeT>(nbytes, 1), alignment);
+		#else
+			Lpvoid memory = NULL;
+			if (posix_memalign(&memory, Max(alignment, sizeof(Lpvoid)), nbytes) != 0)
+				return NULL;
+			return memory;
+		#endif
+		}
+		Void Deallocate(Lpvoid memory, SizeT) override {
+		#if defined(_WIN32)
+			_aligned_free(memory);
+		#else
+			free(memory);
+		#endif
+		}
+	};
+
+
+	static HeapAllocator s_heapAllocator;
+	static Allocator*    s_allocator = &s_heapAllocator;
+
+
+
+	Void SetAllocator(Allocator* allocator) {
+		s_allocator = allocator ? allocator : &s_heapAllocator;
+	}
+
+
+
+	Allocator* GetAllocator() {
+		return s_allocator;
+	}
+
+
+
+	Lpvoid AllocateMemory(SizeT nbytes, SizeT alignment) {
+		return s_allocator->Allocate(nbytes, alignment);
+	}
+
+
+
+	Void FreeMemory(Lpvoid memory, SizeT nbytes) {
+		if (memory)
+			s_allocator->Deallocate(memory, nbytes);
+	}
+
+
+
+	ScratchArena::ScratchArena(SizeT blockSize) :
+		m_blocks(NULL),
+		m_blockSize(blockSize) {
+	}
+
+	ScratchArena::~ScratchArena() {
+		Reset();
+	}
+
+
+
+	/** returns the aligned offset of nbytes within a block,
+		or the block size if they do not fit*/
+	SizeT ScratchArena::FitBlock(const Block* block, SizeT nbytes, SizeT alignment) {
+		const SizeT base  = (SizeT)(block) + ARENA_HEADERSIZE;
+		const SizeT start = ((base + block->used + alignment - 1) & ~(alignment - 1)) - base;
+		return (start + nbytes <= block->size) ? start : block->size;
+	}
+
+
+
+	Lpvoid ScratchArena::Allocate(SizeT nbytes, SizeT alignment) {
+		SizeT start = 0;
+		if (m_blocks && (start = FitBlock(m_blocks, nbytes, alignment)) < m_blocks->size) {
+			m_blocks->used = start + nbytes;
+			return (Byte*)(m_blocks) + ARENA_HEADERSIZE + start;
+		}
+		const SizeT size  = Max(m_blockSize, nbytes + alignment);
+		Block*      block = (Block*)(AllocateMemory(ARENA_HEADERSIZE + size));
+		if (!block) {
+			return NULL;
+		}
+		block->size = size;
+		block->used = 0;
+		start = FitBlock(block, nbytes, alignment);
+		block->used = start + nbytes;
+
+		//requests larger than a block get one of their own, placed behind
+		//the current block so its free space is still used
+		if (m_blocks && size > m_blockSize) {
+			block->next    = m_blocks->next;
+			m_blocks->next = block;
+		}
+		else {
+			block->next = m_blocks;
+			m_blocks    = block;
+		}
+		return (Byte*)(block) + ARENA_HEADERSIZE + start;
+	}
+
+
+
+	Void ScratchArena::Reset() {
+		while (m_blocks) {
+			Block* next = m_blocks->next;
+			FreeMemory(m_blocks, ARENA_HEADERSIZE + m_blocks->size);
+			m_blocks = next;
+		}
+	}
+
+
+
+	SizeT ScratchArena::GetSize() const {
+		SizeT size = 0;
+		for (const Block* block = m_blocks; block; block = block->next) {
+			size += ARENA_HEADERSIZE + block->size;
+		}
+		return size;
+	}
+};
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/
@@ -0,0 +1,187 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzallocator.h												          |
+| Desc: allocator interface and scratch arenas                                |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#ifndef __KZALLOCATOR_H__
+#define __KZALLOCATOR_H__
+/**
+alignment of memory handed out by AllocateMemory and the arenas*/
+#ifndef KZALLOCATOR_ALIGNMENT
+#  define KZALLOCATOR_ALIGNMENT 16
+#endif
+/**
+size of the blocks a scratch arena takes from the allocator*/
+#ifndef KZALLOCATOR_ARENABLOCK
+#  define KZALLOCATOR_ARENABLOCK 0x4000
+#endif
+
+#include <new>
+#include <utility>
+#include <vector>
+#include "kzbasetypes.h"
+#include "kznoncopyable.h"
+namespace kz {
+
+
+
+	/**
+	source of all memory kzaudio allocates. install one with SetAllocator
+	before any audio is loaded, to track audio memory or take it from a
+	pool. calls come from worker threads too, so it must be thread safe.
+	memory the codec libraries allocate internally is not covered.*/
+	class Allocator {
+	public:
+		virtual ~Allocator() {}
+
+		/** returns nbytes of memory aligned to alignment (a power of two),
+			or null if it can not be allocated*/
+		virtual Lpvoid Allocate(SizeT nbytes, SizeT alignment) = 0;
+
+		/** free memory returned by Allocate
+			@param nbytes: the size it was allocated with*/
+		virtual Void Deallocate(Lpvoid memory, SizeT nbytes) = 0;
+	};
+
+
+	/** set the allocator used by kzaudio, null restores the default
+		that uses the c runtime heap [CALLER OWNS THE ALLOCATOR]*/
+	extern Void SetAllocator(Allocator* allocator);
+
+	/** returns the allocator used by kzaudio*/
+	extern Allocator* GetAllocator();
+
+	/** allocate memory from the current allocator, or null on failure*/
+	extern Lpvoid AllocateMemory(SizeT nbytes, SizeT alignment = KZALLOCATOR_ALIGNMENT);
+
+	/** free memory returned by AllocateMemory*/
+	extern Void FreeMemory(Lpvoid memory, SizeT nbytes);
+
+
+
+	/**
+	base of classes created with new, so the objects come from the
+	allocator. the size is passed on from delete, classes deleted through
+	a base pointer need a virtual destructor.*/
+	class Allocated {
+	public:
+		static Lpvoid operator new(SizeT nbytes) {
+			Lpvoid memory = AllocateMemory(nbytes);
+			if (!memory)
+				throw std::bad_alloc();
+			return memory;
+		}
+		static Lpvoid operator new(SizeT, Lpvoid where) {
+			return where;
+		}
+		static Void operator delete(Lpvoid memory, SizeT nbytes) {
+			FreeMemory(memory, nbytes);
+		}
+		static Void operator delete(Lpvoid, Lpvoid) {
+		}
+	};
+
+
+
+	/**
+	standard library allocator over the current allocator, for the
+	containers kzaudio keeps its buffers in*/
+	template<class T> class StlAllocator {
+	public:
+		typedef T value_type;
+
+		StlAllocator() {}
+		template<class U> StlAllocator(const StlAllocator<U>&) {}
+
+		T* allocate(SizeT count) {
+			Lpvoid memory = AllocateMemory(count * sizeof(T),
+				Max<SizeT>(alignof(T), KZALLOCATOR_ALIGNMENT));
+			if (!memory)
+				throw std::bad_alloc();
+			return (T*)(memory);
+		}
+		Void deallocate(T* memory, SizeT count) {
+			FreeMemory(memory, count * sizeof(T));
+		}
+		template<class U> Bool operator==(const StlAllocator<U>&) const {
+			return true;
+		}
+		template<class U> Bool operator!=(const StlAllocator<U>&) const {
+			return false;
+		}
+	};
+
+	typedef std::vector<Byte, StlAllocator<Byte>> BYTEDATA;
+
+
+
+	/**
+	bump allocator for objects and buffers that share a lifetime, such as
+	the decoder and stream of an open file. memory is taken from the
+	allocator in blocks and given back all at once by Reset, objects
+	created in the arena are destroyed, not deleted.*/
+	class ScratchArena final : NonCopyable {
+	public:
+		explicit ScratchArena(SizeT blockSize = KZALLOCATOR_ARENABLOCK);
+		~ScratchArena();
+
+
+		/** returns nbytes of memory that lives until Reset,
+			or null if it can not be allocated*/
+		Lpvoid Allocate(SizeT nbytes, SizeT alignment = KZALLOCATOR_ALIGNMENT);
+
+
+		/** construct an object in the arena, or returns null*/
+		template<class T, class... Args> T* Create(Args&&... args) {
+			Lpvoid memory = Allocate(sizeof(T), alignof(T));
+			return memory ? new (memory) T(std::forward<Args>(args)...) : NULL;
+		}
+
+
+		/** destroy an object created in the arena, its memory is
+			freed with the rest of the arena*/
+		template<class T> static Void Destroy(T* object) {
+			if (object)
+				object->~T();
+		}
+
+
+		/** free all memory of the arena, every object in it must
+			have been destroyed*/
+		Void Reset();
+
+
+		/** returns the bytes taken from the allocator*/
+		SizeT GetSize() const;
+
+
+	private:
+		struct Block {
+			Block* next;
+			SizeT  size;
+			SizeT  used;
+		};
+		static SizeT FitBlock(const Block* block, SizeT nbytes, SizeT alignment);
+
+		Block* m_blocks;
+		SizeT  m_blockSize;
+	};
+};
+/*****************************************************************************/
+#endif//EOF                                                                   |
+/*****************************************************************************/
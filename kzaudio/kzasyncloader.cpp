@@ -0,0 +1,158 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzasyncloader.cpp												          |
+| Desc: decodes sound buffers on worker threads                               |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#include "kzasyncloader.h"
+#include "kzsoundbuffer.h"
+#include "kzthreadpool.h"
+namespace kz {
+
+
+
+	AsyncLoader::AsyncLoader(Uint32 nthreads) {
+		m_pool       = new ThreadPool(nthreads);
+		m_lastHandle = 0;
+	}
+
+
+
+	AsyncLoader::~AsyncLoader() {
+		for (auto& entry : m_jobs) {
+			entry.second->canceled = true;
+		}
+		//the pool runs what is left of its queue, canceled jobs skip
+		//the decode, before the workers are joined
+		delete m_pool;
+		for (auto& entry : m_jobs) {
+			delete entry.second->staging;
+			delete entry.second;
+		}
+	}
+
+
+
+	LOADHANDLE AsyncLoader::LoadAsync(const String& path, SoundBuffer* buffer,
+		LOADPROC callback, Lpvoid user) {
+		Job* job = new Job();
+		job->handle   = ++m_lastHandle;
+		job->path     = path;
+		job->buffer   = buffer;
+		job->callback = callback;
+		job->user     = user;
+		job->staging  = new SoundBuffer(SoundBuffer::Staging());
+		//already on a worker, a pool per file would oversubscribe the cores
+		job->staging->m_serial = true;
+		job->decoded  = false;
+		job->done     = false;
+		job->canceled = false;
+		m_jobs[job->handle] = job;
+
+		m_pool->Submit([this, job]() { Decode(job); });
+		return job->handle;
+	}
+
+
+
+	Void AsyncLoader::Decode(Job* job) {
+		const Bool decoded = !job->canceled &&
+			job->staging->DecodeFile(job->path, &job->desc);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			job->decoded = decoded;
+			job->done    = true;
+			m_completed.push_back(job);
+		}
+		m_done.notify_all();
+	}
+
+
+
+	SizeT AsyncLoader::Update(SizeT maxUploads) {
+		SizeT finished = 0;
+		while (maxUploads == 0 || finished < maxUploads) {
+			Job* job = NULL;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_completed.empty())
+					break;
+				job = m_completed.front();
+				m_completed.pop_front();
+			}
+			m_jobs.erase(job->handle);
+			if (!job->canceled) {
+				const Bool loaded = job->decoded &&
+					job->buffer->Adopt(*job->staging, job->path, job->desc);
+				if (!loaded)
+					m_failed.insert(job->handle);
+				if (job->callback)
+					job->callback(job->buffer, job->path, loaded, job->user);
+			}
+			delete job->staging;
+			delete job;
+			++finished;
+		}
+		return finished;
+	}
+
+
+
+	SizeT AsyncLoader::Finish() {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_done.wait(lock, [this]() { return m_completed.size() == m_jobs.size(); });
+		}
+		return Update();
+	}
+
+
+
+	Void AsyncLoader::Cancel(LOADHANDLE handle) {
+		JOBMAP::iterator job = m_jobs.find(handle);
+		if (job != m_jobs.end() && !job->second->canceled) {
+			job->second->canceled = true;
+			m_failed.insert(handle);
+		}
+	}
+
+
+
+	LOADSTATE AsyncLoader::GetState(LOADHANDLE handle) const {
+		if (handle == 0 || handle > m_lastHandle) {
+			return LOADSTATE_NONE;
+		}
+		if (m_failed.count(handle)) {
+			return LOADSTATE_FAILED;
+		}
+		JOBMAP::const_iterator job = m_jobs.find(handle);
+		if (job == m_jobs.end()) {
+			return LOADSTATE_LOADED;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return job->second->done ? LOADSTATE_DECODED : LOADSTATE_DECODING;
+	}
+
+
+
+	SizeT AsyncLoader::GetPendingCount() const {
+		return m_jobs.size();
+	}
+};
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/
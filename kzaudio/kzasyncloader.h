@@ -0,0 +1,142 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzasyncloader.h												          |
+| Desc: decodes sound buffers on worker threads                               |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#ifndef __KZASYNCLOADER_H__
+#define __KZASYNCLOADER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include "kzaudiointernal.h"
+namespace kz {
+
+
+
+	class ThreadPool;
+
+	/** identifies a load queued with AsyncLoader::LoadAsync, zero is never used*/
+	typedef Uint64 LOADHANDLE;
+
+	/** progress of a queued load*/
+	enum LOADSTATE {
+		LOADSTATE_NONE,      //handle was not returned by this loader
+		LOADSTATE_DECODING,  //queued or being decoded on a worker
+		LOADSTATE_DECODED,   //waiting for Update to upload it
+		LOADSTATE_LOADED,    //uploaded into the buffer
+		LOADSTATE_FAILED     //could not be loaded, or was canceled
+	};
+
+
+
+	/**
+	loads sound buffers without stalling the calling thread. files are
+	opened and decoded on a pool of worker threads, and the finished
+	samples wait in a queue until Update, called once per frame, uploads
+	them and re-attaches the sounds playing the buffers.
+	a buffer must not be used, other than by the sounds playing it, until
+	its load has finished. cancel the load before destroying the buffer.*/
+	class AsyncLoader final : NonCopyable {
+	public:
+
+		/** called from Update once per load, unless it was canceled
+			@param buffer: the buffer that was being loaded
+			@param path:   path the buffer was loaded from
+			@param loaded: true if the buffer was loaded successfully
+			@param user:   the pointer given to LoadAsync*/
+		typedef Void (*LOADPROC)(SoundBuffer* buffer, const String& path,
+			Bool loaded, Lpvoid user);
+
+
+		/**	start the worker threads
+			@param nthreads: number of workers, zero picks one per core*/
+		explicit AsyncLoader(Uint32 nthreads = 0);
+
+		/** loads still queued are dropped, their buffers are left as is*/
+		~AsyncLoader();
+
+
+		/**	queue a file to be decoded into a sound buffer
+			@param path:     path/name of the file to load
+			@param buffer:   buffer to load the sound data into
+			@param callback: optional, reports the load once uploaded
+			@param user:     passed back to the callback
+			@return:         handle to poll the load with GetState*/
+		LOADHANDLE LoadAsync(const String& path, SoundBuffer* buffer,
+			LOADPROC callback = NULL, Lpvoid user = NULL);
+
+
+		/**	upload decoded buffers and run their callbacks. call on the
+			thread that owns the audio device, once per frame.
+			@param maxUploads: most buffers uploaded by this call, zero for all
+			@return:           number of loads finished by this call*/
+		SizeT Update(SizeT maxUploads = 0);
+
+
+		/**	block until every queued load is decoded, then upload them
+			@return: number of loads finished by this call*/
+		SizeT Finish();
+
+
+		/**	drop a queued load. the buffer is left as is and the callback
+			is not run, the load is reported as failed.*/
+		Void Cancel(LOADHANDLE handle);
+
+
+		/** returns the progress of a load. failed loads are remembered
+			until the loader is destroyed, loaded ones are not stored.*/
+		LOADSTATE GetState(LOADHANDLE handle) const;
+
+
+		/** returns the number of loads not finished by Update yet*/
+		SizeT GetPendingCount() const;
+
+
+	private:
+		struct Job {
+			LOADHANDLE        handle;
+			String            path;
+			SoundBuffer*      buffer;
+			LOADPROC          callback;
+			Lpvoid            user;
+			SoundBuffer*      staging;  //decoded samples, without a device buffer
+			AudioDesc         desc;
+			Bool              decoded;
+			Bool              done;     //decode finished, guarded by m_mutex
+			std::atomic<Bool> canceled;
+		};
+		typedef std::unordered_map<LOADHANDLE, Job*> JOBMAP;
+
+		Void Decode(Job* job);
+
+		ThreadPool*                    m_pool;
+		JOBMAP                         m_jobs;       //loads not finished, by handle
+		std::deque<Job*>               m_completed;  //decoded, waiting for upload
+		std::unordered_set<LOADHANDLE> m_failed;
+		LOADHANDLE                     m_lastHandle;
+		mutable std::mutex             m_mutex;
+		std::condition_variable        m_done;       //signals Finish
+	};
+};
+/*****************************************************************************/
+#endif//EOF                                                                   |
+/*****************************************************************************/
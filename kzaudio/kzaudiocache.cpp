@@ -0,0 +1,332 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzaudiocache.cpp												          |
+| Desc: on-disk cache of decoded sounds                                       |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#include <stdio.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "kzaudiocache.h"
+#include "kziostream.h"
+#if defined(_WIN32)
+#  include <windows.h>
+#  include <process.h>
+#  include <sys/utime.h>
+#  define getpid _getpid
+#else
+#  include <dirent.h>
+#  include <unistd.h>
+#  include <utime.h>
+#endif
+namespace kz {
+
+#define AUDIOCACHE_VERSION   1
+#define AUDIOCACHE_EXTENSION ".kzpcm"
+#define AUDIOCACHE_HEADER    44
+#define AUDIOCACHE_SMPL      68
+
+
+	static String s_cacheDirectory;
+	static Uint64 s_cacheMaxBytes = KZAUDIOCACHE_MAXBYTES;
+
+	//size of the cache, listed on the first write then kept as files are
+	//written, so the directory is only listed again when it is too large
+	static std::mutex          s_cacheMutex;
+	static Int64               s_cacheBytes = -1;
+	static std::atomic<Uint32> s_tempCount(0);
+
+
+	struct CacheEntry {
+		String path;
+		Int64  size;
+		Int64  modified;
+	};
+
+
+
+	/** 64-bit FNV-1a over a block of bytes*/
+	static Uint64 Hash(Uint64 hash, const Void* data, SizeT nbytes) {
+		const Byte* bytes = (const Byte*)(data);
+		for (SizeT i = 0; i < nbytes; ++i) {
+			hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+		}
+		return hash;
+	}
+
+
+
+	/** get the size and modification time of a source file*/
+	static Bool GetSourceInfo(const String& filename, Int64* size, Int64* modified) {
+	#if (KZIOBUF_USING_PHYSFS)
+		PHYSFS_Stat info;
+		if (!PHYSFS_stat(filename.c_str(), &info) || info.filesize < 0) {
+			return false;
+		}
+		*size     = (Int64)(info.filesize);
+		*modified = (Int64)(info.modtime);
+	#else
+		struct stat info;
+		if (stat(filename.c_str(), &info) != 0) {
+			return false;
+		}
+		*size     = (Int64)(info.st_size);
+		*modified = (Int64)(info.st_mtime);
+	#endif
+		return true;
+	}
+
+
+
+	/** list the cache files with their sizes and last use*/
+	static Void ListCache(std::vector<CacheEntry>& entries) {
+		const SizeT extension = sizeof(AUDIOCACHE_EXTENSION) - 1;
+		std::vector<String> names;
+	#if defined(_WIN32)
+		WIN32_FIND_DATAA found;
+		HANDLE search = FindFirstFileA(
+			(s_cacheDirectory + "/*" AUDIOCACHE_EXTENSION).c_str(), &found);
+		if (search == INVALID_HANDLE_VALUE) {
+			return;
+		}
+		do {
+			names.push_back(found.cFileName);
+		} while (FindNextFileA(search, &found));
+		FindClose(search);
+	#else
+		DIR* directory = opendir(s_cacheDirectory.c_str());
+		if (!directory) {
+			return;
+		}
+		while (struct dirent* entry = readdir(directory)) {
+			names.push_back(entry->d_name);
+		}
+		closedir(directory);
+	#endif
+		for (const String& name : names) {
+			struct stat info;
+			if (name.length() <= extension ||
+				name.compare(name.length() - extension, extension, AUDIOCACHE_EXTENSION) != 0) {
+				continue;
+			}
+			CacheEntry entry;
+			entry.path = s_cacheDirectory + "/" + name;
+			if (stat(entry.path.c_str(), &info) == 0) {
+				entry.size     = (Int64)(info.st_size);
+				entry.modified = (Int64)(info.st_mtime);
+				entries.push_back(entry);
+			}
+		}
+	}
+
+
+
+	/** remove the least recently used files over the size limit. the
+		caller holds s_cacheMutex*/
+	static Void Evict() {
+		std::vector<CacheEntry> entries;
+		ListCache(entries);
+
+		Uint64 total = 0;
+		for (const CacheEntry& entry : entries) {
+			total += (Uint64)(entry.size);
+		}
+		s_cacheBytes = (Int64)(total);
+		if (total <= s_cacheMaxBytes) {
+			return;
+		}
+		std::sort(entries.begin(), entries.end(),
+			[](const CacheEntry& a, const CacheEntry& b) {
+				return a.modified < b.modified;
+			});
+		for (const CacheEntry& entry : entries) {
+			if (total <= s_cacheMaxBytes)
+				break;
+			if (remove(entry.path.c_str()) == 0)
+				total -= (Uint64)(entry.size);
+		}
+		s_cacheBytes = (Int64)(total);
+	}
+
+
+
+	/** move a finished file over the cache file it replaces, if any*/
+	static Bool MoveOver(const String& from, const String& to) {
+	#if defined(_WIN32)
+		//rename fails on windows when the target exists
+		return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+	#else
+		return rename(from.c_str(), to.c_str()) == 0;
+	#endif
+	}
+
+
+
+	/** append little-endian values to a header*/
+	static Void Put16(std::vector<Byte>& header, Uint32 value) {
+		header.push_back((Byte)(value));
+		header.push_back((Byte)(value >> 8));
+	}
+
+	static Void Put32(std::vector<Byte>& header, Uint32 value) {
+		Put16(header, value & 0xFFFF);
+		Put16(header, value >> 16);
+	}
+
+	static Void PutId(std::vector<Byte>& header, const Char* id) {
+		header.insert(header.end(), id, id + 4);
+	}
+
+
+
+	Void SetAudioCacheDirectory(const String& directory, Uint64 maxBytes) {
+		std::lock_guard<std::mutex> lock(s_cacheMutex);
+		s_cacheDirectory = directory;
+		s_cacheMaxBytes  = maxBytes;
+		s_cacheBytes     = -1;
+
+		const SizeT length = s_cacheDirectory.length();
+		if (length > 1 && (s_cacheDirectory[length - 1] == '/' ||
+			s_cacheDirectory[length - 1] == '\\')) {
+			s_cacheDirectory.erase(length - 1);
+		}
+	}
+
+
+
+	String GetAudioCachePath(const String& filename) {
+		Int64 size, modified;
+		if (s_cacheDirectory.empty() || !GetSourceInfo(filename, &size, &modified)) {
+			return String();
+		}
+		const Uint32 version = AUDIOCACHE_VERSION;
+		Uint64 hash = 0xCBF29CE484222325ULL;
+		hash = Hash(hash, filename.data(), filename.length());
+		hash = Hash(hash, &size, sizeof(size));
+		hash = Hash(hash, &modified, sizeof(modified));
+		hash = Hash(hash, &version, sizeof(version));
+
+		Char name[32];
+		snprintf(name, sizeof(name), "%016llx" AUDIOCACHE_EXTENSION,
+			(unsigned long long)(hash));
+		return s_cacheDirectory + "/" + name;
+	}
+
+
+
+	Bool WriteAudioCache(const String& path, const Int16* samples,
+		Uint64 count, Uint32 nchannels, Uint32 sampleRate,
+		Uint64 loopStart, Uint64 loopEnd) {
+		const Uint64 dataSize = count * sizeof(Int16);
+		const Bool   looped   = loopEnd != 0;
+		if (path.empty() || !samples || nchannels == 0 ||
+			dataSize + AUDIOCACHE_HEADER + AUDIOCACHE_SMPL > 0xFFFFFFFFULL) {
+			return false;
+		}
+		//a plain 16-bit wav, so loads take the mapped path of the wav
+		//decoder. loop points go into a smpl chunk ahead of the data
+		std::vector<Byte> header;
+		header.reserve(AUDIOCACHE_HEADER + AUDIOCACHE_SMPL);
+		PutId(header, "RIFF");
+		Put32(header, (Uint32)(dataSize) + AUDIOCACHE_HEADER - 8 +
+			(looped ? AUDIOCACHE_SMPL : 0));
+		PutId(header, "WAVE");
+		PutId(header, "fmt ");
+		Put32(header, 16);
+		Put16(header, 1);
+		Put16(header, nchannels);
+		Put32(header, sampleRate);
+		Put32(header, sampleRate * nchannels * 2);
+		Put16(header, nchannels * 2);
+		Put16(header, 16);
+		if (looped) {
+			PutId(header, "smpl");
+			Put32(header, AUDIOCACHE_SMPL - 8);
+			for (Int32 i = 0; i < 7; ++i)
+				Put32(header, 0);
+			Put32(header, 1);
+			Put32(header, 0);
+			Put32(header, 0);
+			Put32(header, 0);
+			Put32(header, (Uint32)(loopStart));
+			Put32(header, (Uint32)(loopEnd - 1));
+			Put32(header, 0);
+			Put32(header, 0);
+		}
+		PutId(header, "data");
+		Put32(header, (Uint32)(dataSize));
+
+		//written under a name of its own and moved in place when complete,
+		//unique to the process and write for caches shared by processes
+		Char suffix[32];
+		snprintf(suffix, sizeof(suffix), ".%ld.%u", (long)(getpid()),
+			(unsigned)(++s_tempCount));
+		const String temp = path + suffix;
+
+		FILE* output = fopen(temp.c_str(), "wb");
+		if (!output) {
+			return false;
+		}
+		Bool success = fwrite(header.data(), header.size(), 1, output) == 1;
+	#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+		for (Uint64 i = 0; success && i < count; ++i) {
+			const Byte bytes[2] = { (Byte)(samples[i]), (Byte)(samples[i] >> 8) };
+			success = fwrite(bytes, 2, 1, output) == 1;
+		}
+	#else
+		success = success && (count == 0 ||
+			fwrite(samples, (SizeT)(dataSize), 1, output) == 1);
+	#endif
+		if ((fclose(output) != 0) || !success) {
+			remove(temp.c_str());
+			return false;
+		}
+		std::lock_guard<std::mutex> lock(s_cacheMutex);
+		struct stat replaced;
+		const Int64 oldSize = stat(path.c_str(), &replaced) == 0 ?
+			(Int64)(replaced.st_size) : 0;
+		if (!MoveOver(temp, path)) {
+			remove(temp.c_str());
+			return false;
+		}
+		if (s_cacheBytes < 0) {
+			Evict();
+		}
+		else {
+			s_cacheBytes += (Int64)(header.size() + dataSize) - oldSize;
+			if ((Uint64)(s_cacheBytes) > s_cacheMaxBytes)
+				Evict();
+		}
+		return true;
+	}
+
+
+
+	Void TouchAudioCache(const String& path) {
+	#if defined(_WIN32)
+		_utime(path.c_str(), NULL);
+	#else
+		utime(path.c_str(), NULL);
+	#endif
+	}
+};
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/
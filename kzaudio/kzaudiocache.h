@@ -0,0 +1,70 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzaudiocache.h												          |
+| Desc: on-disk cache of decoded sounds                                       |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#ifndef __KZAUDIOCACHE_H__
+#define __KZAUDIOCACHE_H__
+/**
+default limit of the decoded sound cache in bytes*/
+#ifndef KZAUDIOCACHE_MAXBYTES
+#  define KZAUDIOCACHE_MAXBYTES 0x10000000
+#endif
+
+#include "kzbasetypes.h"
+namespace kz {
+
+
+
+	/** set a directory where sounds decoded by SoundBuffer::Load are kept
+		as 16-bit pcm wav files, so later loads map them (or read them, where
+		files can not be mapped) instead of running the decoder. the directory must exist, empty disables the cache
+		(default). set it before loading any audio.
+		@param directory: where the decoded files are written
+		@param maxBytes:  size the least recently used files are evicted to*/
+	extern Void SetAudioCacheDirectory(const String& directory,
+		Uint64 maxBytes = KZAUDIOCACHE_MAXBYTES);
+
+
+	/** returns the cache file of a source file, named by a hash of the
+		source path, size and modification time, or empty if the cache is
+		disabled or the source is not found. the file may not exist yet.*/
+	extern String GetAudioCachePath(const String& filename);
+
+
+	/** write decoded samples to a cache file, then evict the least
+		recently used files until the cache fits its size limit
+		@param path:       file returned by GetAudioCachePath
+		@param samples:    interleaved 16-bit samples
+		@param count:      number of samples
+		@param nchannels:  channel count
+		@param sampleRate: sample rate of the samples
+		@param loopStart:  first frame of the loop
+		@param loopEnd:    frame after the loop, zero if there is none
+		@return: true if the file was written*/
+	extern Bool WriteAudioCache(const String& path, const Int16* samples,
+		Uint64 count, Uint32 nchannels, Uint32 sampleRate,
+		Uint64 loopStart, Uint64 loopEnd);
+
+
+	/** mark a cache file as used, keeping it from eviction the longest*/
+	extern Void TouchAudioCache(const String& path);
+};
+/*****************************************************************************/
+#endif//EOF                                                                   |
+/*****************************************************************************/
@@ -19,25 +19,131 @@
 | along with this program.  If not, see <http://www.gnu.org/licenses/>.	      |
 ******************************************************************************/ 
 #include <iostream>
+#include <vector>
 #include "kzaudiodecoder.h" 
 namespace kz {
 
 
+
+    struct AudioDecoderFormat {
+        AUDIOPROBEPROC  probe;
+	AUDIOCREATEPROC create;
+    };
+    typedef std::vector<AudioDecoderFormat> FORMATLIST;
+
+
+    template<class T> static AudioDecoder* CreateDecoder(ScratchArena* arena) {
+        return arena ? arena->Create<T>() : new T;
+    }
+
+
+
+    /** returns the registered formats, built-in formats first*/
+    static FORMATLIST& GetFormats() {
+        static FORMATLIST formats = {
+	    { &FileIsFormatWAV, &CreateDecoder<AudioDecoderWAV> },
+	    { &FileIsFormatOGG, &CreateDecoder<AudioDecoderOGG> },
+	#if (KZAUDIODECODER_USING_OPUS)
+	    { &FileIsFormatOpus, &CreateDecoder<AudioDecoderOpus> },
+	#endif
+	#if (KZAUDIODECODER_USING_FLAC)
+	    { &FileIsFormatFLAC, &CreateDecoder<AudioDecoderFLAC> },
+	#endif
+	};
+	return formats;
+    }
+
+
+
+    Void RegisterAudioDecoder(AUDIOPROBEPROC probe, AUDIOCREATEPROC create) {
+        AudioDecoderFormat format = { probe, create };
+	GetFormats().push_back(format);
+    }
+
+
+    /** returns true and the value if comment is "key=<frames>",
+        the key compared regardless of case*/
+    static Bool ParseLoopComment(const Char* comment, Int32 length,
+        const Char* key, Uint64* value) {
+        const Int32 keyLength = (Int32)(strlen(key));
+	if (length <= keyLength + 1 || comment[keyLength] != '=') {
+	    return false;
+	}
+	for (Int32 i = 0; i < keyLength; ++i) {
+	    if (toupper((Byte)(comment[i])) != key[i])
+	        return false;
+	}
+	Uint64 number = 0;
+	for (Int32 i = keyLength + 1; i < length; ++i) {
+	    if (comment[i] < '0' || comment[i] > '9')
+	        return false;
+	    number = number * 10 + (Uint64)(comment[i] - '0');
+	}
+	*value = number;
+	return true;
+    }
+
+
+
+    Bool ParseLoopComments(const Char* const* comments, const Int32* lengths,
+        Int32 count, Uint64 nframes, Uint64* start, Uint64* end) {
+        Uint64 loopStart = 0, loopLength = 0, loopEnd = 0;
+	Bool   hasStart  = false, hasLength = false, hasEnd = false;
+
+	for (Int32 i = 0; i < count; ++i) {
+	    hasStart  |= ParseLoopComment(comments[i], lengths[i], "LOOPSTART",  &loopStart);
+	    hasLength |= ParseLoopComment(comments[i], lengths[i], "LOOPLENGTH", &loopLength);
+	    hasEnd    |= ParseLoopComment(comments[i], lengths[i], "LOOPEND",    &loopEnd);
+	}
+	if (!hasStart) {
+	    return false;
+	}
+	if (hasLength)
+	    loopEnd = loopStart + loopLength;
+	else if (!hasEnd)
+	    loopEnd = nframes;
+
+	if (nframes != 0)
+	    loopEnd = Min(loopEnd, nframes);
+	if (loopStart >= loopEnd) {
+	    return false;
+	}
+	*start = loopStart;
+	*end   = loopEnd;
+	return true;
+    }
+
+
+
     AudioDecoder* CreateAudioDecoder(const String& filename) {
         IObuf file;
 	if (!file.Open(filename)) {
 	    return NULL;
 	}
-	file.Seek(0);
-	if (FileIsFormatOGG(&file)) {
-	    return new AudioDecoderOGG;
+	AudioDecoder* decoder = CreateAudioDecoder(&file);
+	if (!decoder) {
+	    std::cout << "failed to read audio file: " << filename
+	              << ".\n format is not supported" << std::endl;
+	}
+	return decoder;
+    }
+
+
+
+    AudioDecoder* CreateAudioDecoder(IObuf* iobuf, ScratchArena* arena) {
+        Byte  header[AUDIODECODER_PROBESIZE];
+	Int64 nbytes;
+
+	iobuf->Seek(0);
+	nbytes = iobuf->Read(header, (Int64)(sizeof(header)));
+	iobuf->Seek(0);
+	if (nbytes <= 0) {
+	    return NULL;
 	}
-	file.Seek(0);
-	if (FileIsFormatWAV(&file)) {
-	    return new AudioDecoderWAV;
+	for (const AudioDecoderFormat& format : GetFormats()) {
+	    if (format.probe(header, (SizeT)(nbytes)))
+	        return format.create(arena);
 	}
-	std::cout << "failed to read audio file: " << filename
-	          << ".\n format is not supported" << std::endl;
 	return NULL;
     }
 };
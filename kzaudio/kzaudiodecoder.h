@@ -20,14 +20,33 @@
 ******************************************************************************/ 
 #ifndef __KZAUDIODECODER_H__
 #define __KZAUDIODECODER_H__
+/**
+if this define is set to 1 (link with opusfile), Ogg/Opus files are
+decoded as well. set it to 0 to build without opusfile*/
+#ifndef KZAUDIODECODER_USING_OPUS
+#  define KZAUDIODECODER_USING_OPUS 1
+#endif
+/**
+if this define is set to 1 (link with libFLAC), FLAC files are decoded
+as well. set it to 0 to build without libFLAC*/
+#ifndef KZAUDIODECODER_USING_FLAC
+#  define KZAUDIODECODER_USING_FLAC 1
+#endif
 
+#include <vector>
 #include "kzaudiointernal.h"
+#include "kzsampleconv.h"
+#if (KZAUDIODECODER_USING_OPUS)
+struct OggOpusFile; //opusfile.h, only included by kzaudiodecoderopus.cpp
+#endif
 namespace kz {
 
 
+    class HeaderReader;
+
     /**
     abstract base type interface for audio decoders*/
-    class AudioDecoder {
+    class AudioDecoder : public Allocated {
     public:
         virtual ~AudioDecoder() {}
 
@@ -42,9 +61,47 @@ namespace kz {
 	    @return       : samples read (may be less than imax)*/
 	virtual Uint64 Read(Int16* samples, Uint64 imax) = 0;
 
+	/** returns true if the decoder can read float samples*/
+	virtual Bool SupportsFloat() const { return false; }
+
+	/** read audio samples as float in [-1, 1], see SupportsFloat
+	    @param samples: sample array to be filled
+	    @param imax   : maximum samples to be read
+	    @return       : samples read (may be less than imax)*/
+	virtual Uint64 ReadFloat(Float*, Uint64) { return 0; }
+
 	/** change the read position to the given sample offset
 	    @param offset: index of sample to go to (relative to beginning)*/
 	virtual Void Seek(Uint64 offset) = 0;
+
+	/** returns true if seeking is sample exact and decoding is costly
+	    enough that separate ranges of the file are worth decoding on
+	    separate threads, each with its own decoder*/
+	virtual Bool SupportsSegments() const { return false; }
+
+	/** returns the decoded samples in place when the file data already
+	    is native 16-bit pcm held in memory, else null. the pointer stays
+	    valid while the decoder's stream is open.*/
+	virtual const Int16* GetDirectSamples() { return NULL; }
+
+	/** returns the block encoding the sample data can be uploaded in
+	    without decoding, or AUDIOENCODING_PCM16 if it must be decoded
+	    @param framesPerBlock: receives the frames held by each block
+	    @param nbytes:         receives the encoded size, in whole blocks*/
+	virtual AUDIOENCODING GetEncoding(Uint32*, Uint64*) const {
+	    return AUDIOENCODING_PCM16;
+	}
+
+	/** read all of the encoded sample data, see GetEncoding
+	    @param data: receives the encoded blocks
+	    @return:     true if all of the data was read*/
+	virtual Bool ReadEncoded(Byte*) { return false; }
+
+	/** returns the loop stored in the file's metadata
+	    @param start: receives the first frame of the loop
+	    @param end:   receives the frame after the last one of the loop
+	    @return:      false if the file defines no loop*/
+	virtual Bool GetLoopPoints(Uint64*, Uint64*) const { return false; }
     };
 
 
@@ -58,14 +115,38 @@ namespace kz {
         Bool   Open(IObuf* file, AudioDesc* desc) override;
 	Uint64 Read(Int16* samples, Uint64 imax) override;
 	Void   Seek(Uint64 offset) override;
+	const Int16* GetDirectSamples() override;
+	AUDIOENCODING GetEncoding(Uint32* framesPerBlock, Uint64* nbytes) const override;
+	Bool   ReadEncoded(Byte* data) override;
+	Bool   GetLoopPoints(Uint64* start, Uint64* end) const override;
 
     private:
-	Bool Parse(AudioDesc* desc);
+	Bool   Parse(AudioDesc* desc);
+	Bool   ParseADPCM(HeaderReader& reader, Uint16 format);
+	Bool   ParseLoop(HeaderReader& reader, Uint32 size);
+	Void   ParseTrailer(HeaderReader& reader, Uint64 dataSize);
+	Uint64 ReadADPCM(Int16* samples, Uint64 imax);
+	Void   SeekADPCM(Uint64 offset);
+	SizeT  DecodeBlock(Int16* samples);
 
-	IObuf*  m_iobuf;
-	Uint32  m_bytesPerSample;
-	Uint64  m_bufferStart;
-	Uint64  m_bufferEnd;
+	IObuf*             m_iobuf;
+	CONVERTPROC        m_convert;
+	BYTEDATA           m_block;
+	Uint32             m_format;
+	Uint32             m_nchannels;
+	Uint32             m_bytesPerSample;
+	Uint64             m_bufferStart;
+	Uint64             m_bufferEnd;
+	Uint32             m_blockAlign;
+	Uint32             m_framesPerBlock;
+	SAMPLEDATA         m_coefs;
+	SAMPLEDATA         m_decoded;
+	SizeT              m_decodedCount;
+	SizeT              m_decodedOffset;
+	Uint64             m_sampleOffset;
+	Uint64             m_sampleCount;
+	Uint64             m_loopStart;
+	Uint64             m_loopEnd;
     };
 
 
@@ -80,20 +161,160 @@ namespace kz {
 	Bool   Open(IObuf* file, AudioDesc* desc) override;
 	Uint64 Read(Int16* samples, Uint64 imax) override;
 	Void   Seek(Uint64 offset) override;
+	Bool   SupportsFloat() const override;
+	Uint64 ReadFloat(Float* samples, Uint64 imax) override;
+	Bool   SupportsSegments() const override;
+	Bool   GetLoopPoints(Uint64* start, Uint64* end) const override;
 
     private:
+	struct PageEntry {
+	    Int64 granule; //frames decoded by the end of the page
+	    Int64 offset;  //file offset of the page
+	};
+
+	template<class T> Uint64 ReadInterleaved(T* samples, Uint64 imax);
+	Void   BuildIndex();
+	Bool   LoadIndex(const String& path);
+	Void   SaveIndex(const String& path) const;
+	String GetIndexPath() const;
+	Void   Discard(Int64 nframes);
+
 	struct OggVorbis_File* m_oggfile;
+	IObuf*                 m_iobuf;
 	Uint32                 m_nchannels;
+	std::vector<PageEntry, StlAllocator<PageEntry>> m_index;
+	Bool                   m_indexed;
+	Uint64                 m_loopStart;
+	Uint64                 m_loopEnd;
+    };
+
+
+
+#if (KZAUDIODECODER_USING_OPUS)
+    /**
+    audio decoder for Ogg/Opus format files, always decoded at 48 kHz*/
+    class AudioDecoderOpus : public AudioDecoder {
+    public:
+        AudioDecoderOpus();
+	~AudioDecoderOpus();
+
+	Bool   Open(IObuf* file, AudioDesc* desc) override;
+	Uint64 Read(Int16* samples, Uint64 imax) override;
+	Void   Seek(Uint64 offset) override;
+	Bool   SupportsFloat() const override;
+	Uint64 ReadFloat(Float* samples, Uint64 imax) override;
+	Bool   SupportsSegments() const override;
+	Bool   GetLoopPoints(Uint64* start, Uint64* end) const override;
+
+    private:
+	template<class T> Uint64 ReadInterleaved(T* samples, Uint64 imax);
+	Int32  Decode(Int16* samples, Int32 count);
+	Int32  Decode(Float* samples, Int32 count);
+
+	::OggOpusFile*      m_opusfile;
+	Uint32              m_nchannels;
+	Bool                m_stereo;
+	Uint64              m_loopStart;
+	Uint64              m_loopEnd;
+    };
+#endif
+
+
+
+#if (KZAUDIODECODER_USING_FLAC)
+    /**
+    audio decoder for native FLAC format files*/
+    class AudioDecoderFLAC : public AudioDecoder {
+    public:
+        AudioDecoderFLAC();
+	~AudioDecoderFLAC();
+
+	Bool   Open(IObuf* file, AudioDesc* desc) override;
+	Uint64 Read(Int16* samples, Uint64 imax) override;
+	Void   Seek(Uint64 offset) override;
+	Bool   SupportsSegments() const override;
+	Bool   GetLoopPoints(Uint64* start, Uint64* end) const override;
+
+    private:
+	friend struct FLACCallbacks;
+	Void   Write(const Int32* const* planes, Uint32 nframes, Uint32 bits);
+
+	Lpvoid     m_flac;          //FLAC__StreamDecoder
+	IObuf*     m_iobuf;
+	Uint32     m_nchannels;
+	Uint32     m_sampleRate;
+	Uint64     m_frameCount;
+	Int16*     m_target;        //caller's buffer, frames are decoded into it
+	Uint64     m_targetCount;   //samples the caller's buffer still takes
+	SAMPLEDATA m_pending;       //decoded samples that did not fit
+	SizeT      m_pendingOffset;
+	Bool       m_ended;
+	Uint64     m_loopStart;
+	Uint64     m_loopEnd;
     };
+#endif
+
+
 
 
+    /** number of leading bytes of a file handed to format probes*/
+    enum { AUDIODECODER_PROBESIZE = 64 };
 
+    /** returns true if the leading bytes of a file identify the format.
+        nbytes may be less than AUDIODECODER_PROBESIZE for short files*/
+    typedef Bool (*AUDIOPROBEPROC)(const Byte* header, SizeT nbytes);
 
-    /** validate that the given file is WAV format*/
-    extern Bool FileIsFormatWAV(IObuf* iobuf);
+    /** returns a new decoder instance for a format, constructed in the
+        arena if one is given (see ScratchArena::Create), else with new*/
+    typedef AudioDecoder* (*AUDIOCREATEPROC)(ScratchArena* arena);
 
-    /** validate that the given file is OGG format*/
-    extern Bool FileIsFormatOGG(IObuf* iobuf);
+
+    /** register a decoder with CreateAudioDecoder. formats are probed in
+        registration order, after the built-in WAV, OGG, Opus and FLAC
+	decoders.
+	not thread safe, register formats before loading any audio.
+	@param probe:  detects the format from the leading file bytes
+	@param create: creates a decoder once the format is detected*/
+    extern Void RegisterAudioDecoder(AUDIOPROBEPROC probe, AUDIOCREATEPROC create);
+
+
+    /** validate that the given file header is WAV format*/
+    extern Bool FileIsFormatWAV(const Byte* header, SizeT nbytes);
+
+    /** validate that the given file header is OGG/Vorbis format*/
+    extern Bool FileIsFormatOGG(const Byte* header, SizeT nbytes);
+
+#if (KZAUDIODECODER_USING_OPUS)
+    /** validate that the given file header is Ogg/Opus format*/
+    extern Bool FileIsFormatOpus(const Byte* header, SizeT nbytes);
+#endif
+
+#if (KZAUDIODECODER_USING_FLAC)
+    /** validate that the given file header is FLAC format*/
+    extern Bool FileIsFormatFLAC(const Byte* header, SizeT nbytes);
+#endif
+
+
+    /** read a loop from the LOOPSTART, LOOPLENGTH or LOOPEND comments of
+        Vorbis, Opus and FLAC files ("KEY=value", values in frames). the
+	end is exclusive, without one the loop runs to the end of the file.
+	@param comments: comment strings, not necessarily null terminated
+	@param lengths:  length of each comment
+	@param count:    number of comments
+	@param nframes:  frames in the file, zero if unknown
+	@param start:    receives the first frame of the loop
+	@param end:      receives the frame after the last one of the loop
+	@return:         false if the comments hold no valid loop*/
+    extern Bool ParseLoopComments(const Char* const* comments, const Int32* lengths,
+        Int32 count, Uint64 nframes, Uint64* start, Uint64* end);
+
+
+    /** set a directory where the seek indices of OGG/Vorbis files are
+        cached. each file's pages are scanned once, on its first open, and
+	later seeks land on the right page instead of bisecting the file.
+	the directory must exist, empty disables the index (default) and
+	seeks use libvorbis' bisection. set it before loading any audio.*/
+    extern Void SetOggIndexDirectory(const String& directory);
 
 
     /** create a decoder for the given file-
@@ -103,6 +324,19 @@ namespace kz {
 			 [CALLER IS RESPONSIBLE FOR FREEING THE INSTANCE]*/
     extern AudioDecoder* CreateAudioDecoder(const String& filename);
 
+
+    /** create a decoder for an already opened stream. the format is
+        detected from a single read of the leading bytes, so the same
+	stream can be handed to the decoder afterwards-
+        @param iobuf:  stream to inspect, rewound to the beginning
+	               before this function returns
+	@param arena:  arena the decoder is created in, or null
+	@param return: AudioDecoder that can read the given stream,
+			 or null if the format is unsupported.
+			 [CALLER IS RESPONSIBLE FOR FREEING THE INSTANCE,
+			 DESTROYED WITH THE ARENA IF ONE IS GIVEN]*/
+    extern AudioDecoder* CreateAudioDecoder(IObuf* iobuf, ScratchArena* arena = NULL);
+
 };
 /*****************************************************************************/  
 #endif//EOF                                                                   |
@@ -0,0 +1,281 @@
+/*****************************************************************************\ 
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 			          					      |
+| File: kzaudiodecoderflac.cpp					              |
+| Desc: interface for flac audio                           	              |
+|     						                              |
+| This program is free software: you can redistribute it and/or modify	      |
+| it under the terms of the GNU General Public License as published by	      |
+| the Free Software Foundation, either version 3 of the License, or	      |
+| (at your option) any later version.			                      |
+| 					 				      |
+| This program is distributed in the hope that it will be useful,             |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of	      |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the		      |
+| GNU General Public License for more details.			    	      |
+| 							  		      |
+| You should have received a copy of the GNU General Public License	      |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.	      |
+******************************************************************************/
+#include "kzaudiodecoder.h" 
+#if (KZAUDIODECODER_USING_FLAC)
+#include <FLAC/stream_decoder.h>
+namespace kz {
+
+
+
+    /** libFLAC callbacks, reading through the decoder's IObuf*/
+    struct FLACCallbacks {
+        static FLAC__StreamDecoderReadStatus Read(const FLAC__StreamDecoder*,
+	    FLAC__byte buffer[], SizeT* nbytes, Lpvoid data) {
+	    IObuf* file = ((AudioDecoderFLAC*)(data))->m_iobuf;
+	    Int64  read = file->Read(buffer, (Int64)(*nbytes));
+	    if (read < 0) {
+	        *nbytes = 0;
+		return FLAC__STREAM_DECODER_READ_STATUS_ABORT;
+	    }
+	    *nbytes = (SizeT)(read);
+	    return read == 0 ? FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM :
+	        FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
+	}
+
+
+	static FLAC__StreamDecoderSeekStatus Seek(const FLAC__StreamDecoder*,
+	    FLAC__uint64 offset, Lpvoid data) {
+	    IObuf* file = ((AudioDecoderFLAC*)(data))->m_iobuf;
+	    return file->Seek((Int64)(offset)) == -1 ?
+	        FLAC__STREAM_DECODER_SEEK_STATUS_ERROR :
+		FLAC__STREAM_DECODER_SEEK_STATUS_OK;
+	}
+
+
+	static FLAC__StreamDecoderTellStatus Tell(const FLAC__StreamDecoder*,
+	    FLAC__uint64* offset, Lpvoid data) {
+	    IObuf* file = ((AudioDecoderFLAC*)(data))->m_iobuf;
+	    *offset = (FLAC__uint64)(file->Tell());
+	    return FLAC__STREAM_DECODER_TELL_STATUS_OK;
+	}
+
+
+	static FLAC__StreamDecoderLengthStatus Length(const FLAC__StreamDecoder*,
+	    FLAC__uint64* length, Lpvoid data) {
+	    IObuf* file = ((AudioDecoderFLAC*)(data))->m_iobuf;
+	    Int64  size = file->GetSize();
+	    if (size < 0) {
+	        return FLAC__STREAM_DECODER_LENGTH_STATUS_UNSUPPORTED;
+	    }
+	    *length = (FLAC__uint64)(size);
+	    return FLAC__STREAM_DECODER_LENGTH_STATUS_OK;
+	}
+
+
+	static FLAC__bool Eof(const FLAC__StreamDecoder*, Lpvoid data) {
+	    IObuf* file = ((AudioDecoderFLAC*)(data))->m_iobuf;
+	    Int64  size = file->GetSize();
+	    return size >= 0 && file->Tell() >= size;
+	}
+
+
+	static FLAC__StreamDecoderWriteStatus Write(const FLAC__StreamDecoder*,
+	    const FLAC__Frame* frame, const FLAC__int32* const planes[], Lpvoid data) {
+	    AudioDecoderFLAC* decoder = (AudioDecoderFLAC*)(data);
+	    if (frame->header.channels != decoder->m_nchannels) {
+	        return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+	    }
+	    decoder->Write(planes, frame->header.blocksize, frame->header.bits_per_sample);
+	    return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+	}
+
+
+	static Void Metadata(const FLAC__StreamDecoder*,
+	    const FLAC__StreamMetadata* metadata, Lpvoid data) {
+	    AudioDecoderFLAC* decoder = (AudioDecoderFLAC*)(data);
+	    if (metadata->type == FLAC__METADATA_TYPE_STREAMINFO) {
+	        decoder->m_nchannels  = metadata->data.stream_info.channels;
+		decoder->m_sampleRate = metadata->data.stream_info.sample_rate;
+		decoder->m_frameCount = metadata->data.stream_info.total_samples;
+	    }
+	    else if (metadata->type == FLAC__METADATA_TYPE_VORBIS_COMMENT) {
+	        //the stream info always comes first, the frame count is known
+	        const FLAC__StreamMetadata_VorbisComment& tags = metadata->data.vorbis_comment;
+		std::vector<const Char*> comments(tags.num_comments);
+		std::vector<Int32>       lengths(tags.num_comments);
+		for (Uint32 i = 0; i < tags.num_comments; ++i) {
+		    comments[i] = (const Char*)(tags.comments[i].entry);
+		    lengths[i]  = (Int32)(tags.comments[i].length);
+		}
+		ParseLoopComments(comments.data(), lengths.data(), (Int32)(tags.num_comments),
+		    decoder->m_frameCount, &decoder->m_loopStart, &decoder->m_loopEnd);
+	    }
+	}
+
+
+	static Void Error(const FLAC__StreamDecoder*,
+	    FLAC__StreamDecoderErrorStatus, Lpvoid) {
+	    //damaged frames are skipped, libFLAC resyncs on its own
+	}
+    };
+
+
+
+    Bool FileIsFormatFLAC(const Byte* header, SizeT nbytes) {
+        return nbytes >= 4 && memcmp(header, "fLaC", 4) == 0;
+    }
+    /**************************************************************************
+    **************************************************************************/
+
+
+
+
+
+    /**************************************************************************
+    **************************************************************************/
+    AudioDecoderFLAC::AudioDecoderFLAC() {
+        m_flac          = NULL;
+	m_iobuf         = NULL;
+	m_nchannels     = 0;
+	m_sampleRate    = 0;
+	m_frameCount    = 0;
+	m_target        = NULL;
+	m_targetCount   = 0;
+	m_pendingOffset = 0;
+	m_ended         = false;
+	m_loopStart     = 0;
+	m_loopEnd       = 0;
+    }
+
+
+
+    AudioDecoderFLAC::~AudioDecoderFLAC() {
+        if (m_flac) {
+	    FLAC__StreamDecoder* flac = (FLAC__StreamDecoder*)(m_flac);
+	    FLAC__stream_decoder_finish(flac);
+	    FLAC__stream_decoder_delete(flac);
+	    m_flac = NULL;
+	}
+    }
+
+
+
+    Bool AudioDecoderFLAC::Open(IObuf* iobuf, AudioDesc* desc) {
+        FLAC__StreamDecoder* flac = FLAC__stream_decoder_new();
+	if (!flac) {
+	    return false;
+	}
+	m_flac  = flac;
+	m_iobuf = iobuf;
+	FLAC__stream_decoder_set_metadata_respond(flac, FLAC__METADATA_TYPE_VORBIS_COMMENT);
+
+	//the seek table is read along with the stream info, libFLAC
+	//uses it to start its seeks near the target frame
+	if (FLAC__stream_decoder_init_stream(flac,
+	        &FLACCallbacks::Read, &FLACCallbacks::Seek, &FLACCallbacks::Tell,
+	        &FLACCallbacks::Length, &FLACCallbacks::Eof, &FLACCallbacks::Write,
+	        &FLACCallbacks::Metadata, &FLACCallbacks::Error, this) !=
+	    FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+	    return false;
+	}
+	if (!FLAC__stream_decoder_process_until_end_of_metadata(flac) ||
+	    m_nchannels == 0 || m_sampleRate == 0) {
+	    return false;
+	}
+	desc->nchannels   = m_nchannels;
+	desc->sampleRate  = m_sampleRate;
+	desc->sampleCount = m_frameCount * m_nchannels;
+	return true;
+    }
+
+
+
+    Void AudioDecoderFLAC::Write(const Int32* const* planes, Uint32 nframes, Uint32 bits) {
+        //as much as fits goes straight to the caller, the rest is held back
+        const Uint32 direct = (Uint32)(Min<Uint64>(nframes, m_targetCount / m_nchannels));
+	if (direct > 0) {
+	    InterleavePCM(planes, m_nchannels, direct, bits, m_target);
+	    m_target      += direct * m_nchannels;
+	    m_targetCount -= direct * m_nchannels;
+	}
+	if (direct < nframes) {
+	    const Int32* rest[8];
+	    for (Uint32 c = 0; c < m_nchannels; ++c)
+	        rest[c] = planes[c] + direct;
+	    m_pending.resize((nframes - direct) * m_nchannels);
+	    m_pendingOffset = 0;
+	    InterleavePCM(rest, m_nchannels, nframes - direct, bits, m_pending.data());
+	}
+    }
+
+
+
+    Uint64 AudioDecoderFLAC::Read(Int16* samples, Uint64 imax) {
+        FLAC__StreamDecoder* flac = (FLAC__StreamDecoder*)(m_flac);
+	const Uint64 wanted = imax / m_nchannels * m_nchannels;
+	Uint64 count = 0;
+
+	if (m_ended) {
+	    return 0;
+	}
+	//samples left over from the last frame come first
+	if (m_pendingOffset < m_pending.size()) {
+	    count = Min<Uint64>(wanted, m_pending.size() - m_pendingOffset);
+	    memcpy(samples, m_pending.data() + m_pendingOffset, (SizeT)(count) * sizeof(Int16));
+	    m_pendingOffset += (SizeT)(count);
+	}
+	//then whole frames are decoded in place
+	m_target      = samples + count;
+	m_targetCount = wanted - count;
+	while (m_targetCount > 0) {
+	    FLAC__StreamDecoderState state = FLAC__stream_decoder_get_state(flac);
+	    if (state == FLAC__STREAM_DECODER_END_OF_STREAM ||
+	        state >= FLAC__STREAM_DECODER_OGG_ERROR ||
+		!FLAC__stream_decoder_process_single(flac)) {
+	        break;
+	    }
+	}
+	count = wanted - m_targetCount;
+	m_target      = NULL;
+	m_targetCount = 0;
+	return count;
+    }
+
+
+
+    Void AudioDecoderFLAC::Seek(Uint64 offset) {
+        FLAC__StreamDecoder* flac = (FLAC__StreamDecoder*)(m_flac);
+	const Uint64 frame = offset / m_nchannels;
+
+	//the frame holding the target is written from the target on
+	m_pending.clear();
+	m_pendingOffset = 0;
+	m_ended = frame >= m_frameCount && m_frameCount != 0;
+	if (m_ended) {
+	    return;
+	}
+	if (!FLAC__stream_decoder_seek_absolute(flac, frame) &&
+	    FLAC__stream_decoder_get_state(flac) == FLAC__STREAM_DECODER_SEEK_ERROR) {
+	    FLAC__stream_decoder_flush(flac);
+	}
+    }
+
+
+
+    Bool AudioDecoderFLAC::GetLoopPoints(Uint64* start, Uint64* end) const {
+        if (m_loopEnd == 0) {
+	    return false;
+	}
+	*start = m_loopStart;
+	*end   = m_loopEnd;
+	return true;
+    }
+
+
+
+    Bool AudioDecoderFLAC::SupportsSegments() const {
+        return true;
+    }
+};
+#endif
+/*****************************************************************************/  
+//EOF                                                                         |
+/*****************************************************************************/
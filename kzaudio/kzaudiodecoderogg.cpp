@@ -18,10 +18,21 @@
 | You should have received a copy of the GNU General Public License	      |
 | along with this program.  If not, see <http://www.gnu.org/licenses/>.	      |
 ******************************************************************************/
+#include <algorithm>
 #include <vorbis/vorbisfile.h>
 #include "kzaudiodecoder.h" 
+#include "kzheaderreader.h"
 namespace kz {
 
+#define OGG_READFRAMES   0x1000
+#define OGG_PAGEHEADER   27
+#define OGG_INDEXWINDOW  0x10000
+#define OGG_INDEXMAGIC   0x494F5A4B //KZOI
+#define OGG_INDEXVERSION 1
+
+
+    static String s_indexDirectory;
+
 
 
     static SizeT Read(Lpvoid ptr, SizeT size, SizeT nmemb, Lpvoid data) {
@@ -33,16 +44,7 @@ namespace kz {
 
     static Int32 Seek(Lpvoid data, Int64 offset, Int32 whence) {
         IObuf* file = (IObuf*)(data);
-        switch (whence) {
-        case SEEK_SET:
-	    break;
-	case SEEK_CUR:
-	    offset += file->Tell();
-	    break;
-	case SEEK_END:
-	    offset = file->GetSize() - offset;
-	}
-	return (Int32)(file->Seek(offset));
+	return file->Seek(offset, whence) == -1 ? -1 : 0;
     }
 
 
@@ -60,13 +62,23 @@ namespace kz {
 
 
 
-    Bool FileIsFormatOGG(IObuf* iobuf) {
-        OggVorbis_File file;
-	if (ov_test_callbacks(iobuf, &file, NULL, 0, s_callbacks) == 0) {
-	    ov_clear(&file);
-	    return true;
+    Void SetOggIndexDirectory(const String& directory) {
+        s_indexDirectory = directory;
+    }
+
+
+
+    Bool FileIsFormatOGG(const Byte* header, SizeT nbytes) {
+        //first page capture pattern, then the vorbis identification
+	//packet right after the page's segment table
+        if (nbytes < 27 || memcmp(header, "OggS", 4) != 0) {
+	    return false;
+	}
+	SizeT packet = 27 + (SizeT)(header[26]);
+	if (nbytes < packet + 7) {
+	    return false;
 	}
-	return false;
+	return memcmp(header + packet, "\x01vorbis", 7) == 0;
     }
     /**************************************************************************
     **************************************************************************/
@@ -79,20 +91,26 @@ namespace kz {
     **************************************************************************/
     AudioDecoderOGG::AudioDecoderOGG() {
         m_nchannels = 0;
-        m_oggfile = new OggVorbis_File();
-        m_oggfile->datasource = NULL;
+        m_iobuf = NULL;
+        m_indexed = false;
+        m_loopStart = 0;
+        m_loopEnd = 0;
+        m_oggfile = (OggVorbis_File*)(AllocateMemory(sizeof(OggVorbis_File)));
+        if (m_oggfile) {
+            memset(m_oggfile, 0, sizeof(OggVorbis_File));
+        }
     }
 
 
 
     AudioDecoderOGG::~AudioDecoderOGG() {
-        if (m_oggfile->datasource) {
+        if (m_oggfile && m_oggfile->datasource) {
             ov_clear(m_oggfile);
             m_oggfile->datasource = NULL;
 	    m_nchannels = 0;
         }
 	if (m_oggfile) {
-	    delete m_oggfile;
+	    FreeMemory(m_oggfile, sizeof(OggVorbis_File));
 	    m_oggfile = NULL;
 	}
     }
@@ -103,6 +121,9 @@ namespace kz {
         Int32        status;
         vorbis_info* vorbisInfo;
 
+	if (!m_oggfile) {
+	    return false;
+	}
 	status = ov_open_callbacks(iobuf, m_oggfile, NULL, 0, s_callbacks);
 	if (status < 0) {
 	    return false;
@@ -113,38 +134,256 @@ namespace kz {
 	desc->sampleCount = (SizeT)(ov_pcm_total(m_oggfile, -1) * vorbisInfo->channels);
 
 	m_nchannels = desc->nchannels;
+	m_iobuf     = iobuf;
+	m_indexed   = false;
+
+	vorbis_comment* comment = ov_comment(m_oggfile, -1);
+	if (comment) {
+	    ParseLoopComments(comment->user_comments, comment->comment_lengths,
+	        comment->comments, (Uint64)(ov_pcm_total(m_oggfile, -1)),
+		&m_loopStart, &m_loopEnd);
+	}
+
+	//with a cache directory the index is ready before the first seek
+	String indexPath = GetIndexPath();
+	if (!indexPath.empty()) {
+	    if (!LoadIndex(indexPath)) {
+	        BuildIndex();
+		SaveIndex(indexPath);
+	    }
+	    m_indexed = true;
+	}
 	return true;
     }
 
 
 
     Void AudioDecoderOGG::Seek(Uint64 offset) {
-        ov_pcm_seek(m_oggfile, (Int64)(offset / m_nchannels));
+        const Int64 frame = (Int64)(offset / m_nchannels);
+	if (frame == 0) {
+	    //the start needs no search, whether or not there is an index
+	    if (ov_raw_seek(m_oggfile, 0) != 0)
+	        ov_pcm_seek(m_oggfile, 0);
+	    return;
+	}
+	//without an index directory the file is never scanned here, a seek
+	//from a stream's Update would stall on reading the whole file
+	if (!m_indexed || m_index.empty()) {
+	    ov_pcm_seek(m_oggfile, frame);
+	    return;
+	}
+	//restart decoding at the last page ending at or before the frame
+	auto page = std::upper_bound(m_index.begin(), m_index.end(), frame,
+	    [](Int64 value, const PageEntry& entry) {
+	        return value < entry.granule;
+	    });
+	Int64 position = (page == m_index.begin()) ? 0 : (page - 1)->offset;
+
+	if (ov_raw_seek(m_oggfile, position) != 0 ||
+	    ov_pcm_tell(m_oggfile) > frame) {
+	    ov_pcm_seek(m_oggfile, frame);
+	    return;
+	}
+	//then decode forward to the exact frame
+	Discard(frame - ov_pcm_tell(m_oggfile));
     }
 
 
 
-    Uint64 AudioDecoderOGG::Read(Int16* samples, Uint64 imax) {
+    Void AudioDecoderOGG::Discard(Int64 nframes) {
+        Float** planes;
+	while (nframes > 0) {
+	    Long framesRead = ov_read_float(m_oggfile, &planes,
+	        (Int32)(Min<Int64>(nframes, OGG_READFRAMES)), NULL);
+	    if (framesRead <= 0)
+	        break;
+	    nframes -= framesRead;
+	}
+    }
+
+
+
+    Void AudioDecoderOGG::BuildIndex() {
+        m_indexed = true;
+	m_index.clear();
+
+	//chained files keep using ov_pcm_seek
+	if (ov_streams(m_oggfile) != 1) {
+	    return;
+	}
+	const Uint32 serial = (Uint32)(ov_serialnumber(m_oggfile, -1));
+	const Int64  resume = m_iobuf->Tell();
+
+	//walk the page headers, skipping over the page bodies
+	m_iobuf->Seek(0);
+	HeaderReader reader(m_iobuf, OGG_INDEXWINDOW);
+	for (;;) {
+	    Byte  header[OGG_PAGEHEADER];
+	    Byte  lacing[255];
+	    Int64 offset = reader.Tell();
+
+	    if (reader.Read(header, OGG_PAGEHEADER) != OGG_PAGEHEADER ||
+	        memcmp(header, "OggS", 4) != 0) {
+	        break;
+	    }
+	    const Int64 nsegments = header[26];
+	    if (reader.Read(lacing, nsegments) != nsegments) {
+	        break;
+	    }
+	    Int64  body    = 0;
+	    Int64  granule = 0;
+	    Uint32 pageSerial = 0;
+	    for (Int64 i = 0; i < nsegments; ++i)
+	        body += lacing[i];
+	    for (Int32 i = 7; i >= 0; --i)
+	        granule = (granule << 8) | header[6 + i];
+	    for (Int32 i = 3; i >= 0; --i)
+	        pageSerial = (pageSerial << 8) | header[14 + i];
+
+	    //header pages and pages without a finished packet are skipped
+	    if (pageSerial == serial && granule > 0 &&
+	        (m_index.empty() || granule > m_index.back().granule)) {
+	        PageEntry entry = { granule, offset };
+		m_index.push_back(entry);
+	    }
+	    reader.Seek(offset + OGG_PAGEHEADER + nsegments + body);
+	}
+	m_iobuf->Seek(resume);
+    }
+
+
+
+    String AudioDecoderOGG::GetIndexPath() const {
+        if (s_indexDirectory.empty()) {
+	    return String();
+	}
+	//size, serial and length tell files apart without hashing them
+	Char name[64];
+	snprintf(name, sizeof(name), "%llx-%08lx-%llx.kzidx",
+	    (unsigned long long)(m_iobuf->GetSize()),
+	    (unsigned long)(ov_serialnumber(m_oggfile, -1)),
+	    (unsigned long long)(ov_pcm_total(m_oggfile, -1)));
+
+	const Char last = s_indexDirectory[s_indexDirectory.length() - 1];
+	if (last == '/' || last == '\\')
+	    return s_indexDirectory + name;
+	return s_indexDirectory + "/" + name;
+    }
+
+
+
+    Bool AudioDecoderOGG::LoadIndex(const String& path) {
+        FILE* input = fopen(path.c_str(), "rb");
+	if (!input) {
+	    return false;
+	}
+	Uint32 header[3] = { 0, 0, 0 };
+	Bool   success   = fread(header, sizeof(header), 1, input) == 1 &&
+	    header[0] == OGG_INDEXMAGIC && header[1] == OGG_INDEXVERSION;
+	if (success && header[2] <= m_iobuf->GetSize() / OGG_PAGEHEADER) {
+	    m_index.resize(header[2]);
+	    success = m_index.empty() || fread(m_index.data(),
+	        sizeof(PageEntry), m_index.size(), input) == m_index.size();
+	}
+	fclose(input);
+
+	//a stale or damaged index is rebuilt
+	const Int64 size = m_iobuf->GetSize();
+	for (SizeT i = 0; success && i < m_index.size(); ++i) {
+	    success = m_index[i].offset >= 0 && m_index[i].offset < size &&
+	        (i == 0 || m_index[i].granule > m_index[i - 1].granule);
+	}
+	if (!success) {
+	    m_index.clear();
+	}
+	return success;
+    }
+
+
+
+    Void AudioDecoderOGG::SaveIndex(const String& path) const {
+        //decoders of the same file may save at once, so the index is
+        //written under a name of its own and moved in place when complete
+        Char suffix[32];
+	snprintf(suffix, sizeof(suffix), ".%p", (const Void*)(this));
+	const String temp = path + suffix;
+
+	FILE* output = fopen(temp.c_str(), "wb");
+	if (!output) {
+	    return;
+	}
+	const Uint32 header[3] = {
+	    OGG_INDEXMAGIC, OGG_INDEXVERSION, (Uint32)(m_index.size())
+	};
+	Bool success = fwrite(header, sizeof(header), 1, output) == 1 &&
+	    (m_index.empty() || fwrite(m_index.data(), sizeof(PageEntry),
+	        m_index.size(), output) == m_index.size());
+	if ((fclose(output) != 0) || !success || rename(temp.c_str(), path.c_str()) != 0) {
+	    remove(temp.c_str());
+	}
+    }
+
+
+
+    template<class T>
+    Uint64 AudioDecoderOGG::ReadInterleaved(T* samples, Uint64 imax) {
         Uint64 count = 0;
-	Int32  bytesToRead;
-	Long   bytesRead, samplesRead;
+	Float** planes;
+	Long    framesToRead, framesRead;
 
-	while (count < imax) {
-	    bytesToRead = (Int32)(imax - count) * (Int32)sizeof(Int16);
+	//decode to float and convert/interleave ourselves, whole frames only
+	while (count + m_nchannels <= imax) {
+	    framesToRead = (Long)(Min<Uint64>(
+	        (imax - count) / m_nchannels, OGG_READFRAMES));
 
-	    bytesRead = ov_read(m_oggfile,
-				(Char*)samples,
-				bytesToRead, 0, 2, 1, NULL);
+	    framesRead = ov_read_float(m_oggfile, &planes,
+	                               (Int32)(framesToRead), NULL);
 
-	    if (bytesRead > 0) {
-	        samplesRead = bytesRead / (Long)sizeof(Int16);
-		count += (Uint64)(samplesRead);
-		samples += samplesRead;
+	    if (framesRead > 0) {
+	        InterleaveFloat(planes, m_nchannels, (SizeT)(framesRead), samples);
+		count += (Uint64)(framesRead) * m_nchannels;
+		samples += framesRead * m_nchannels;
 	    }
 	    else break;
 	}
 	return count;
     }
+
+
+
+    Uint64 AudioDecoderOGG::Read(Int16* samples, Uint64 imax) {
+        return ReadInterleaved(samples, imax);
+    }
+
+
+
+    Bool AudioDecoderOGG::SupportsFloat() const {
+        return true;
+    }
+
+
+
+    Uint64 AudioDecoderOGG::ReadFloat(Float* samples, Uint64 imax) {
+        return ReadInterleaved(samples, imax);
+    }
+
+
+
+    Bool AudioDecoderOGG::GetLoopPoints(Uint64* start, Uint64* end) const {
+        if (m_loopEnd == 0) {
+	    return false;
+	}
+	*start = m_loopStart;
+	*end   = m_loopEnd;
+	return true;
+    }
+
+
+
+    Bool AudioDecoderOGG::SupportsSegments() const {
+        //ov_pcm_seek and the page index both land on the exact frame
+        return true;
+    }
 };
 /*****************************************************************************/  
 //EOF                                                                         |
@@ -0,0 +1,211 @@
+/*****************************************************************************\ 
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 			          					      |
+| File: kzaudiodecoderopus.cpp					              |
+| Desc: interface for opus audio                           	              |
+|     						                              |
+| This program is free software: you can redistribute it and/or modify	      |
+| it under the terms of the GNU General Public License as published by	      |
+| the Free Software Foundation, either version 3 of the License, or	      |
+| (at your option) any later version.			                      |
+| 					 				      |
+| This program is distributed in the hope that it will be useful,             |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of	      |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the		      |
+| GNU General Public License for more details.			    	      |
+| 							  		      |
+| You should have received a copy of the GNU General Public License	      |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.	      |
+******************************************************************************/
+#include "kzaudiodecoder.h" 
+#if (KZAUDIODECODER_USING_OPUS)
+#include <opusfile.h>
+namespace kz {
+
+#define OPUS_SAMPLERATE 48000
+#define OPUS_READFRAMES 0x1000
+
+
+
+    static Int32 Read(Lpvoid data, Byte* ptr, Int32 nbytes) {
+        IObuf* file = (IObuf*)(data);
+	return (Int32)(file->Read(ptr, (Int64)(nbytes)));
+    }
+
+
+
+    static Int32 Seek(Lpvoid data, opus_int64 offset, Int32 whence) {
+        IObuf* file = (IObuf*)(data);
+	return file->Seek((Int64)(offset), whence) == -1 ? -1 : 0;
+    }
+
+
+
+    static opus_int64 Tell(Lpvoid data) {
+        IObuf* file = (IObuf*)(data);
+	return (opus_int64)(file->Tell());
+    }
+
+
+
+    static const OpusFileCallbacks s_callbacks = {
+        &Read, &Seek, &Tell, NULL
+    };
+
+
+
+    Bool FileIsFormatOpus(const Byte* header, SizeT nbytes) {
+        //first page capture pattern, then the opus identification
+	//header right after the page's segment table
+        if (nbytes < 27 || memcmp(header, "OggS", 4) != 0) {
+	    return false;
+	}
+	SizeT packet = 27 + (SizeT)(header[26]);
+	if (nbytes < packet + 8) {
+	    return false;
+	}
+	return memcmp(header + packet, "OpusHead", 8) == 0;
+    }
+    /**************************************************************************
+    **************************************************************************/
+
+
+
+
+
+    /**************************************************************************
+    **************************************************************************/
+    AudioDecoderOpus::AudioDecoderOpus() {
+        m_opusfile  = NULL;
+	m_nchannels = 0;
+	m_stereo    = false;
+	m_loopStart = 0;
+	m_loopEnd   = 0;
+    }
+
+
+
+    AudioDecoderOpus::~AudioDecoderOpus() {
+        if (m_opusfile) {
+	    op_free(m_opusfile);
+	    m_opusfile = NULL;
+	}
+    }
+
+
+
+    Bool AudioDecoderOpus::Open(IObuf* iobuf, AudioDesc* desc) {
+        Int32 status = 0;
+
+	m_opusfile = op_open_callbacks(iobuf, &s_callbacks, NULL, 0, &status);
+	if (!m_opusfile) {
+	    return false;
+	}
+	//chained links may differ in channel count, those get mixed to stereo
+	m_nchannels = (Uint32)(op_channel_count(m_opusfile, 0));
+	for (Int32 link = 1; link < op_link_count(m_opusfile); ++link) {
+	    if ((Uint32)(op_channel_count(m_opusfile, link)) != m_nchannels) {
+	        m_stereo    = true;
+		m_nchannels = 2;
+		break;
+	    }
+	}
+	const Int64 nframes = op_pcm_total(m_opusfile, -1);
+
+	desc->nchannels   = m_nchannels;
+	desc->sampleRate  = OPUS_SAMPLERATE;
+	desc->sampleCount = nframes > 0 ? (Uint64)(nframes) * m_nchannels : 0;
+
+	const OpusTags* tags = op_tags(m_opusfile, -1);
+	if (tags) {
+	    ParseLoopComments(tags->user_comments, tags->comment_lengths,
+	        tags->comments, desc->sampleCount / Max(m_nchannels, 1u),
+		&m_loopStart, &m_loopEnd);
+	}
+	return m_nchannels != 0;
+    }
+
+
+
+    Void AudioDecoderOpus::Seek(Uint64 offset) {
+        //exact to the sample, opusfile decodes the pre-roll itself
+        op_pcm_seek(m_opusfile, (Int64)(offset / m_nchannels));
+    }
+
+
+
+    Int32 AudioDecoderOpus::Decode(Int16* samples, Int32 count) {
+        if (m_stereo)
+	    return op_read_stereo(m_opusfile, samples, count);
+	return op_read(m_opusfile, samples, count, NULL);
+    }
+
+
+
+    Int32 AudioDecoderOpus::Decode(Float* samples, Int32 count) {
+        if (m_stereo)
+	    return op_read_float_stereo(m_opusfile, samples, count);
+	return op_read_float(m_opusfile, samples, count, NULL);
+    }
+
+
+
+    template<class T>
+    Uint64 AudioDecoderOpus::ReadInterleaved(T* samples, Uint64 imax) {
+        Uint64 count = 0;
+
+	//opusfile interleaves in place, whole frames only
+	while (count + m_nchannels <= imax) {
+	    const Int32 framesToRead = (Int32)(Min<Uint64>(
+	        (imax - count) / m_nchannels, OPUS_READFRAMES));
+
+	    const Int32 framesRead = Decode(samples, framesToRead * (Int32)(m_nchannels));
+	    if (framesRead > 0) {
+	        count   += (Uint64)(framesRead) * m_nchannels;
+		samples += framesRead * m_nchannels;
+	    }
+	    else break;
+	}
+	return count;
+    }
+
+
+
+    Uint64 AudioDecoderOpus::Read(Int16* samples, Uint64 imax) {
+        return ReadInterleaved(samples, imax);
+    }
+
+
+
+    Bool AudioDecoderOpus::SupportsFloat() const {
+        return true;
+    }
+
+
+
+    Uint64 AudioDecoderOpus::ReadFloat(Float* samples, Uint64 imax) {
+        return ReadInterleaved(samples, imax);
+    }
+
+
+
+    Bool AudioDecoderOpus::GetLoopPoints(Uint64* start, Uint64* end) const {
+        if (m_loopEnd == 0) {
+	    return false;
+	}
+	*start = m_loopStart;
+	*end   = m_loopEnd;
+	return true;
+    }
+
+
+
+    Bool AudioDecoderOpus::SupportsSegments() const {
+        return true;
+    }
+};
+#endif
+/*****************************************************************************/  
+//EOF                                                                         |
+/*****************************************************************************/
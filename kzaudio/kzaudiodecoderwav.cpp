@@ -18,77 +18,49 @@
 | You should have received a copy of the GNU General Public License			  |
 | along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
 ******************************************************************************/
+#include "kzadpcm.h"
 #include "kzaudiodecoder.h"
+#include "kzheaderreader.h"
 namespace kz {
 
 #define WAV_CHUNKSIZE      0x000C  
 #define WAV_FORMAT_PCM     0x0001 
+#define WAV_FORMAT_MSADPCM 0x0002
+#define WAV_FORMAT_IMA4    0x0011
 #define WAV_FORMAT_EXT     0xFFFE
+#define WAV_SAMPLERSIZE    0x0024
+#define WAV_SAMPLELOOPSIZE 0x0018
 #define WAV_SUBFORMAT_PCM  "\x01\x00\x00\x00\x00\x00\x10\x00"\
                            "\x80\x00\x00\xAA\x00\x38\x9B\x71" 
+#define WAV_BLOCKSAMPLES   0x4000
 
 
 
-	/** Decode stream with 8-bit value*/
-	static Bool Decode8Bit(IObuf* iobuf, Uint8& value) {
-		return (SizeT)(iobuf->Read(&value, sizeof(value))) == sizeof(value);
+	/** Decode header with unsigned 16-bit value*/
+	static Bool Decode16BitU(HeaderReader& reader, Uint16& value) {
+		return reader.ReadU16(&value);
 	}
 
 
 
-	/** Decode stream with 16-bit value*/
-	static Bool Decode16Bit(IObuf* iobuf, Int16& value) {
-		Byte bytes[sizeof(value)];
-		if ((SizeT)(iobuf->Read(bytes, (Int64)(sizeof(bytes)))) != sizeof(bytes))
-			return false;
-		value = (Int16)(bytes[0] | (bytes[1] << 0x8));
-		return true;
-	}
-
-
-
-	/** Decode stream with unsigned 16-bit value*/
-	static Bool Decode16BitU(IObuf* iobuf, Uint16& value) {
-		Byte bytes[sizeof(value)];
-		if ((SizeT)(iobuf->Read(bytes, (Int64)(sizeof(bytes)))) != sizeof(bytes))
-			return false;
-		value = (Uint16)(bytes[0] | (bytes[1] << 0x8));
-		return true;
-	}
-
-
-
-	/** Decode stream with 24-bit value*/
-	static Bool Decode24bit(IObuf* iobuf, Uint32& value) {
-		Byte bytes[3];
-		if ((SizeT)(iobuf->Read(bytes, (Int64)(sizeof(bytes)))) != sizeof(bytes))
-			return false;
-		value = (Uint32)(bytes[0] |
-			(bytes[1] << 0x8) |
-			(bytes[2] << 0x10));
-		return true;
+	/** Decode header with 32-bit value*/
+	static Bool Decode32Bit(HeaderReader& reader, Uint32& value) {
+		return reader.ReadU32(&value);
 	}
 
 
 
-	/** Decode stream with 32-bit value*/
-	static Bool Decode32Bit(IObuf* iobuf, Uint32& value) {
-		Byte bytes[sizeof(value)];
-		if ((SizeT)(iobuf->Read(bytes, (Int64)(sizeof(bytes)))) != sizeof(bytes))
-			return false;
-		value = (Uint32)(bytes[0] |
-			(bytes[1] << 0x8) |
-			(bytes[2] << 0x10) |
-			(bytes[3] << 0x18));
-		return true;
+	/** number of frames held by an adpcm block of the given size*/
+	static Uint32 GetBlockFrames(Uint32 format, Uint32 nbytes, Uint32 nchannels) {
+		if (format == WAV_FORMAT_IMA4)
+			return GetFramesIMA4(nbytes, nchannels);
+		return GetFramesMSADPCM(nbytes, nchannels);
 	}
 
 
 
-	Bool FileIsFormatWAV(IObuf* iobuf) {
-		Char header[WAV_CHUNKSIZE];
-
-		if (iobuf->Read(header, sizeof(header)) < (Int64)(sizeof(header)))
+	Bool FileIsFormatWAV(const Byte* header, SizeT nbytes) {
+		if (nbytes < WAV_CHUNKSIZE)
 			return false;
 		return (
 			(header[0]  == 'R') && (header[1]  == 'I') &&
@@ -107,95 +79,147 @@ namespace kz {
 	**************************************************************************/
 	AudioDecoderWAV::AudioDecoderWAV() {
 		m_iobuf = NULL;
+		m_convert = NULL;
+		m_format = WAV_FORMAT_PCM;
+		m_nchannels = 0;
 		m_bytesPerSample = 0;
 		m_bufferStart = 0;
 		m_bufferEnd = 0;
+		m_blockAlign = 0;
+		m_framesPerBlock = 0;
+		m_decodedCount = 0;
+		m_decodedOffset = 0;
+		m_sampleOffset = 0;
+		m_sampleCount = 0;
+		m_loopStart = 0;
+		m_loopEnd = 0;
 	}
 
 
 
 	Bool AudioDecoderWAV::Open(IObuf* iobuf, AudioDesc* desc) {
 		m_iobuf = iobuf;
-		return Parse(desc);
+		if (!Parse(desc))
+			return false;
+
+		if (m_format != WAV_FORMAT_PCM) {
+			m_block.resize(m_blockAlign);
+			m_decoded.resize(m_framesPerBlock * m_nchannels);
+			return true;
+		}
+		m_convert = GetPCMConverter(m_bytesPerSample);
+		if (m_bytesPerSample != 2) {
+			//16-bit is read straight into the caller's samples
+			m_block.resize(WAV_BLOCKSAMPLES * m_bytesPerSample);
+		}
+		return true;
 	}
 
 
 
 	Void AudioDecoderWAV::Seek(Uint64 offset) {
+		if (m_format != WAV_FORMAT_PCM) {
+			SeekADPCM(offset);
+			return;
+		}
 		m_iobuf->Seek((Int64)(m_bufferStart + offset * m_bytesPerSample));
 	}
 
 
 
+	const Int16* AudioDecoderWAV::GetDirectSamples() {
+	#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+		return NULL;
+	#else
+		Int64 available = 0;
+		const Byte* view = m_iobuf->GetView(&available);
+		if (!view || m_bytesPerSample != 2) {
+			return NULL;
+		}
+		//the view starts at the read position, rebase it onto the data chunk
+		Int64 position = m_iobuf->Tell();
+		if (position + available < (Int64)(m_bufferEnd)) {
+			return NULL;
+		}
+		const Byte* data = view - position + m_bufferStart;
+		if ((SizeT)(data) % sizeof(Int16) != 0) {
+			return NULL;
+		}
+		return (const Int16*)(data);
+	#endif
+	}
+
+
+
 	Uint64 AudioDecoderWAV::Read(Int16* samples, Uint64 imax) {
-		Uint64 count = 0;
-		Uint64 startPos = (Uint64)m_iobuf->Tell();
-
-		while ((count < imax) &&
-			(startPos + count * m_bytesPerSample < m_bufferEnd)) {
-
-			switch (m_bytesPerSample) {
-			case 1:
-			{
-				Uint8 sample = 0;
-				if (Decode8Bit(m_iobuf, sample))
-					*samples++ = (Int16)(((Int16)(sample)-0x80) << 0x8);
-				else return count;
-				break;
-			}
-			case 2:
-			{
-				Int16 sample = 0;
-				if (Decode16Bit(m_iobuf, sample))
-					*samples++ = sample;
-				else return count;
-				break;
-			}
-			case 3:
-			{
-				Uint32 sample = 0;
-				if (Decode24bit(m_iobuf, sample))
-					*samples++ = (Int16)(sample >> 0x8);
-				else return count;
+		if (m_format != WAV_FORMAT_PCM) {
+			return ReadADPCM(samples, imax);
+		}
+		Uint64 startPos = (Uint64)(m_iobuf->Tell());
+		if (!m_convert || startPos >= m_bufferEnd) {
+			return 0;
+		}
+		Uint64 count = Min(imax, (m_bufferEnd - startPos) / m_bytesPerSample);
+
+		Int64 available = 0;
+		const Byte* view = m_iobuf->GetView(&available);
+		if (view) {
+			//mapped stream, convert straight from the file data
+			count = Min(count, (Uint64)(available) / m_bytesPerSample);
+			m_convert(view, samples, (SizeT)(count));
+			m_iobuf->Seek((Int64)(startPos + count * m_bytesPerSample));
+			return count;
+		}
+		Uint64 total = 0;
+		while (total < count) {
+			Uint64 nsamples = Min<Uint64>(count - total, WAV_BLOCKSAMPLES);
+			Int64  nbytes   = (Int64)(nsamples * m_bytesPerSample);
+			Byte*  block    = m_block.empty() ?
+				(Byte*)(samples + total) : m_block.data();
+
+			//one read per block, then convert the whole block at once
+			Int64 bytesRead = m_iobuf->Read(block, nbytes);
+			if (bytesRead <= 0) {
 				break;
 			}
-			case 4:
-			{
-				Uint32 sample = 0;
-				if (Decode32Bit(m_iobuf, sample))
-					*samples++ = (Int16)(sample >> 0x10);
-				else return count;
+			nsamples = (Uint64)(bytesRead) / m_bytesPerSample;
+			m_convert(block, samples + total, (SizeT)(nsamples));
+			total += nsamples;
+
+			if (bytesRead < nbytes) {
 				break;
 			}
-			default: return 0;
-			}
-			++count;
 		}
-		return count;
+		return total;
 	}
 
 
 
 	Bool AudioDecoderWAV::Parse(AudioDesc* info) {
+		//the chunks are parsed from one read of the file's first few KB
+		HeaderReader reader(m_iobuf);
 		Char mainChunk[WAV_CHUNKSIZE];
 
-		if ((SizeT)(m_iobuf->Read(mainChunk,
+		if ((SizeT)(reader.Read(mainChunk,
 			(Int64)(sizeof(mainChunk)))) != sizeof(mainChunk)) {
 			return false;
 		}
-		Bool foundChunk = false;
+		Bool   foundChunk = false;
+		Uint32 factFrames = 0;
+		Bool   foundFact  = false;
+		Uint32 dataSize   = 0;
 
 		while (!foundChunk) {
 			Char subChunkId[4];
-			if ((SizeT)(m_iobuf->Read(subChunkId,
+			if ((SizeT)(reader.Read(subChunkId,
 				(Int64)(sizeof(subChunkId)))) != sizeof(subChunkId)) {
 				return false;
 			}
 			Uint32 subChunkSize = 0;
-			if (!Decode32Bit(m_iobuf, subChunkSize)) {
+			if (!Decode32Bit(reader, subChunkSize)) {
 				return false;
 			}
-			Int64 subChunkStart = m_iobuf->Tell();
+			Int64 subChunkStart = reader.Tell();
 			if (subChunkStart == -1) {
 				return false;
 			}
@@ -204,38 +228,49 @@ namespace kz {
 				(subChunkId[2] == 't') && (subChunkId[3] == ' ')) {
 
 				Uint16 format = 0;
-				if (!Decode16BitU(m_iobuf, format)) {
+				if (!Decode16BitU(reader, format)) {
 					return false;
 				}
 				if ((format != WAV_FORMAT_PCM) &&
-					(format != WAV_FORMAT_EXT)) {
+					(format != WAV_FORMAT_EXT) &&
+					(format != WAV_FORMAT_MSADPCM) &&
+					(format != WAV_FORMAT_IMA4)) {
 					return false;
 				}
 				Uint16 channelCount = 0;
-				if (!Decode16BitU(m_iobuf, channelCount)) {
+				if (!Decode16BitU(reader, channelCount)) {
 					return false;
 				}
 				info->nchannels = channelCount;
+				m_nchannels = channelCount;
 
 				Uint32 sampleRate = 0;
-				if (!Decode32Bit(m_iobuf, sampleRate)) {
+				if (!Decode32Bit(reader, sampleRate)) {
 					return false;
 				}
 				info->sampleRate = sampleRate;
 
 				Uint32 byteRate = 0;
-				if (!Decode32Bit(m_iobuf, byteRate)) {
+				if (!Decode32Bit(reader, byteRate)) {
 					return false;
 				}
 				Uint16 blockAlign = 0;
-				if (!Decode16BitU(m_iobuf, blockAlign)) {
+				if (!Decode16BitU(reader, blockAlign)) {
 					return false;
 				}
 				Uint16 bitsPerSample = 0;
-				if (!Decode16BitU(m_iobuf, bitsPerSample)) {
+				if (!Decode16BitU(reader, bitsPerSample)) {
 					return false;
 				}
-				if (bitsPerSample != 0x08 && bitsPerSample != 0x10 &&
+				m_format = (format == WAV_FORMAT_EXT) ? WAV_FORMAT_PCM : format;
+				m_blockAlign = blockAlign;
+
+				if (m_format != WAV_FORMAT_PCM) {
+					if (bitsPerSample != 0x04 || !ParseADPCM(reader, format)) {
+						return false;
+					}
+				}
+				else if (bitsPerSample != 0x08 && bitsPerSample != 0x10 &&
 					bitsPerSample != 0x18 && bitsPerSample != 0x20) {
 					return false;
 				}
@@ -244,22 +279,22 @@ namespace kz {
 				if (format == WAV_FORMAT_EXT) {
 					// Extension size
 					Uint16 extensionSize = 0;
-					if (!Decode16BitU(m_iobuf, extensionSize)) {
+					if (!Decode16BitU(reader, extensionSize)) {
 						return false;
 					}
 					// Valid bits per sample
 					Uint16 validBitsPerSample = 0;
-					if (!Decode16BitU(m_iobuf, validBitsPerSample)) {
+					if (!Decode16BitU(reader, validBitsPerSample)) {
 						return false;
 					}
 					// Channel mask
 					Uint32 channelMask = 0;
-					if (!Decode32Bit(m_iobuf, channelMask)) {
+					if (!Decode32Bit(reader, channelMask)) {
 						return false;
 					}
 					// Subformat
 					Char subformat[16];
-					if ((SizeT)(m_iobuf->Read(subformat,
+					if ((SizeT)(reader.Read(subformat,
 						(Int64)(sizeof(subformat)))) != sizeof(subformat)) {
 						return false;
 					}
@@ -273,24 +308,277 @@ namespace kz {
 					}
 				}
 				// Skip potential extra information
-				if (m_iobuf->Seek(subChunkStart + subChunkSize) == -1)
+				if (reader.Seek(subChunkStart + subChunkSize) == -1)
 					return false;
 			}
 			else if ((subChunkId[0] == 'd') && (subChunkId[1] == 'a') &&
 				(subChunkId[2] == 't') && (subChunkId[3] == 'a')) {
 
-				info->sampleCount = subChunkSize / m_bytesPerSample;
-
 				// Store the start and end position of samples in the file
 				m_bufferStart = (Uint64)(subChunkStart);
-				m_bufferEnd = m_bufferStart + info->sampleCount * m_bytesPerSample;
+				dataSize = subChunkSize;
+
+				if (m_format != WAV_FORMAT_PCM) {
+					//whole blocks plus whatever the last, short block holds
+					Uint64 frames = (Uint64)(subChunkSize / m_blockAlign) * m_framesPerBlock +
+						Min(m_framesPerBlock, GetBlockFrames(m_format,
+							subChunkSize % m_blockAlign, m_nchannels));
+					if (foundFact)
+						frames = Min<Uint64>(frames, factFrames);
+
+					info->sampleCount = frames * m_nchannels;
+					m_bufferEnd = m_bufferStart + subChunkSize;
+				}
+				else {
+					info->sampleCount = subChunkSize / m_bytesPerSample;
+					m_bufferEnd = m_bufferStart + info->sampleCount * m_bytesPerSample;
+				}
+				m_sampleCount = info->sampleCount;
+				m_sampleOffset = 0;
 				foundChunk = true;
 			}
-			else if (m_iobuf->Seek(
-				m_iobuf->Tell() + subChunkSize) == -1) {
+			else if ((subChunkId[0] == 'f') && (subChunkId[1] == 'a') &&
+				(subChunkId[2] == 'c') && (subChunkId[3] == 't')) {
+
+				// Frame count of compressed formats
+				if (!Decode32Bit(reader, factFrames)) {
+					return false;
+				}
+				foundFact = true;
+				if (reader.Seek(subChunkStart + subChunkSize) == -1)
+					return false;
+			}
+			else if ((subChunkId[0] == 's') && (subChunkId[1] == 'm') &&
+				(subChunkId[2] == 'p') && (subChunkId[3] == 'l')) {
+
+				// Sampler loop points
+				if (!ParseLoop(reader, subChunkSize) ||
+					reader.Seek(subChunkStart + subChunkSize) == -1)
+					return false;
+			}
+			else if (reader.Seek(
+				reader.Tell() + subChunkSize) == -1) {
 				return false;
 			}
 		}
+		if (m_loopEnd == 0) {
+			ParseTrailer(reader, dataSize);
+		}
+		return m_iobuf->Seek((Int64)(m_bufferStart)) != -1;
+	}
+
+
+
+	Void AudioDecoderWAV::ParseTrailer(HeaderReader& reader, Uint64 dataSize) {
+		//editors usually append the smpl chunk after the sample data,
+		//only files with chunks past the data pay for the extra read
+		const Int64 fileSize = m_iobuf->GetSize();
+		Int64 next = (Int64)(m_bufferStart + dataSize + (dataSize & 1));
+
+		while (m_loopEnd == 0 && next + 8 <= fileSize) {
+			Char   chunkId[4];
+			Uint32 chunkSize = 0;
+			if (reader.Seek(next) == -1 ||
+				reader.Read(chunkId, 4) != 4 || !Decode32Bit(reader, chunkSize)) {
+				return;
+			}
+			if (memcmp(chunkId, "smpl", 4) == 0) {
+				ParseLoop(reader, chunkSize);
+				return;
+			}
+			next += 8 + (Int64)(chunkSize) + (chunkSize & 1);
+		}
+	}
+
+
+
+	Bool AudioDecoderWAV::ParseLoop(HeaderReader& reader, Uint32 size) {
+		if (size < WAV_SAMPLERSIZE + WAV_SAMPLELOOPSIZE) {
+			return true;
+		}
+		//sampler fields up to the loop count, then the first loop's
+		//cue id and type ahead of its frames, the end frame is inclusive
+		const Int64 chunkStart = reader.Tell();
+		Uint32 loopCount = 0, start = 0, end = 0;
+		if (reader.Seek(chunkStart + 28) == -1 ||
+			!Decode32Bit(reader, loopCount) ||
+			reader.Seek(chunkStart + WAV_SAMPLERSIZE + 8) == -1 ||
+			!Decode32Bit(reader, start) ||
+			!Decode32Bit(reader, end)) {
+			return false;
+		}
+		if (loopCount > 0 && start <= end) {
+			m_loopStart = start;
+			m_loopEnd   = (Uint64)(end) + 1;
+		}
+		return true;
+	}
+
+
+
+	Bool AudioDecoderWAV::ParseADPCM(HeaderReader& reader, Uint16 format) {
+		Uint16 extensionSize = 0;
+		Uint16 framesPerBlock = 0;
+		if (!Decode16BitU(reader, extensionSize) || extensionSize < 2 ||
+			!Decode16BitU(reader, framesPerBlock)) {
+			return false;
+		}
+		if (m_nchannels == 0 || framesPerBlock == 0 ||
+			framesPerBlock > GetBlockFrames(format, m_blockAlign, m_nchannels)) {
+			return false;
+		}
+		m_framesPerBlock = framesPerBlock;
+
+		if (format == WAV_FORMAT_MSADPCM) {
+			Uint16 ncoefs = 0;
+			if (m_nchannels > 2 || !Decode16BitU(reader, ncoefs) || ncoefs == 0) {
+				return false;
+			}
+			m_coefs.resize(ncoefs * 2);
+			for (auto& coef : m_coefs) {
+				Uint16 value = 0;
+				if (!Decode16BitU(reader, value))
+					return false;
+				coef = (Int16)(value);
+			}
+		}
+		return true;
+	}
+
+
+
+	SizeT AudioDecoderWAV::DecodeBlock(Int16* samples) {
+		Int64 position = m_iobuf->Tell();
+		if (position < 0 || (Uint64)(position) >= m_bufferEnd) {
+			return 0;
+		}
+		Int64 nbytes = m_iobuf->Read(m_block.data(), (Int64)(Min<Uint64>(
+			m_blockAlign, m_bufferEnd - (Uint64)(position))));
+		if (nbytes <= 0) {
+			return 0;
+		}
+		const Uint32 nframes = Min(m_framesPerBlock,
+			GetBlockFrames(m_format, (Uint32)(nbytes), m_nchannels));
+		Int16* dest = samples ? samples : m_decoded.data();
+
+		if (m_format == WAV_FORMAT_IMA4) {
+			DecodeIMA4(m_block.data(), m_nchannels, nframes, dest);
+		}
+		else if (!DecodeMSADPCM(m_block.data(), m_nchannels, nframes,
+			m_coefs.data(), (Uint32)(m_coefs.size() / 2), dest)) {
+			return 0;
+		}
+		const SizeT count = (SizeT)(nframes) * m_nchannels;
+		m_decodedCount  = samples ? 0 : count;
+		m_decodedOffset = 0;
+		return count;
+	}
+
+
+
+	Uint64 AudioDecoderWAV::ReadADPCM(Int16* samples, Uint64 imax) {
+		const SizeT blockSamples = m_decoded.size();
+		Uint64 total = 0;
+
+		imax = Min(imax, m_sampleCount - m_sampleOffset);
+		while (total < imax) {
+			if (m_decodedOffset < m_decodedCount) {
+				//rest of a block decoded earlier
+				SizeT count = (SizeT)(Min<Uint64>(imax - total,
+					m_decodedCount - m_decodedOffset));
+				memcpy(samples + total, m_decoded.data() + m_decodedOffset,
+					count * sizeof(Int16));
+				m_decodedOffset += count;
+				total += count;
+				continue;
+			}
+			//whole blocks are decoded straight into the caller's samples
+			Bool  direct  = imax - total >= blockSamples;
+			SizeT decoded = DecodeBlock(direct ? samples + total : NULL);
+			if (decoded == 0) {
+				break;
+			}
+			if (direct) {
+				total += decoded;
+			}
+		}
+		m_sampleOffset += total;
+		return total;
+	}
+
+
+
+	Void AudioDecoderWAV::SeekADPCM(Uint64 offset) {
+		const Uint64 frame = Min(offset, m_sampleCount) / m_nchannels;
+		const Uint64 block = frame / m_framesPerBlock;
+
+		m_decodedCount  = 0;
+		m_decodedOffset = 0;
+		m_sampleOffset  = frame * m_nchannels;
+		m_iobuf->Seek((Int64)(m_bufferStart + block * m_blockAlign));
+
+		//decode the block holding the frame and skip up to it
+		if (frame % m_framesPerBlock) {
+			DecodeBlock(NULL);
+			m_decodedOffset = Min(m_decodedCount,
+				(SizeT)(frame % m_framesPerBlock) * m_nchannels);
+		}
+	}
+
+
+
+	AUDIOENCODING AudioDecoderWAV::GetEncoding(Uint32* framesPerBlock,
+		Uint64* nbytes) const {
+		AUDIOENCODING encoding = AUDIOENCODING_PCM16;
+		if (m_format == WAV_FORMAT_IMA4) {
+			encoding = AUDIOENCODING_IMA4;
+		}
+		else if (m_format == WAV_FORMAT_MSADPCM &&
+			m_coefs.size() == MSADPCM_NUMCOEFS * 2 &&
+			memcmp(m_coefs.data(), MSADPCM_COEFS, sizeof(MSADPCM_COEFS)) == 0) {
+			//OpenAL only knows the standard coefficients
+			encoding = AUDIOENCODING_MSADPCM;
+		}
+		//OpenAL derives the block size from the frame count
+		if (encoding == AUDIOENCODING_PCM16 || m_framesPerBlock !=
+			GetBlockFrames(m_format, m_blockAlign, m_nchannels)) {
+			return AUDIOENCODING_PCM16;
+		}
+		*framesPerBlock = m_framesPerBlock;
+		*nbytes = (m_bufferEnd - m_bufferStart + m_blockAlign - 1) /
+			m_blockAlign * m_blockAlign;
+		return encoding;
+	}
+
+
+
+	Bool AudioDecoderWAV::ReadEncoded(Byte* data) {
+		Uint32 framesPerBlock = 0;
+		Uint64 nbytes = 0;
+		if (GetEncoding(&framesPerBlock, &nbytes) == AUDIOENCODING_PCM16) {
+			return false;
+		}
+		const Int64 size = (Int64)(m_bufferEnd - m_bufferStart);
+		if (m_iobuf->Seek((Int64)(m_bufferStart)) == -1 ||
+			m_iobuf->Read(data, size) != size) {
+			return false;
+		}
+		//pad a short last block out to the full block size
+		memset(data + size, 0, (SizeT)(nbytes - (Uint64)(size)));
+		SeekADPCM(m_sampleOffset);
+		return true;
+	}
+
+
+
+	Bool AudioDecoderWAV::GetLoopPoints(Uint64* start, Uint64* end) const {
+		const Uint64 nframes = m_nchannels ? m_sampleCount / m_nchannels : 0;
+		const Uint64 loopEnd = Min(m_loopEnd, nframes);
+		if (m_loopStart >= loopEnd) {
+			return false;
+		}
+		*start = m_loopStart;
+		*end   = loopEnd;
 		return true;
 	}
 };
@@ -113,6 +113,53 @@ namespace kz {
 		}
 		return format ? format : 0;
 	}
+
+
+
+	Int32 AudioDevice::GetFloatFormat(Uint32 nchannels) {
+		if (!alIsExtensionPresent("AL_EXT_FLOAT32")) {
+			return 0;
+		}
+		switch (nchannels) {
+		case 1:  return alGetEnumValue("AL_FORMAT_MONO_FLOAT32");
+		case 2:  return alGetEnumValue("AL_FORMAT_STEREO_FLOAT32");
+		default: return 0;
+		}
+	}
+
+
+
+	Int32 AudioDevice::GetEncodedFormat(AUDIOENCODING encoding,
+		Uint32 nchannels, Uint32 framesPerBlock) {
+		const Char* extension;
+		const Char* formats[2];
+		Uint32      defaultFrames;
+
+		switch (encoding) {
+		case AUDIOENCODING_IMA4:
+			extension     = "AL_EXT_IMA4";
+			formats[0]    = "AL_FORMAT_MONO_IMA4";
+			formats[1]    = "AL_FORMAT_STEREO_IMA4";
+			defaultFrames = 65;
+			break;
+		case AUDIOENCODING_MSADPCM:
+			extension     = "AL_SOFT_MSADPCM";
+			formats[0]    = "AL_FORMAT_MONO_MSADPCM_SOFT";
+			formats[1]    = "AL_FORMAT_STEREO_MSADPCM_SOFT";
+			defaultFrames = 64;
+			break;
+		default: return 0;
+		}
+		if (nchannels < 1 || nchannels > 2 || !alIsExtensionPresent(extension)) {
+			return 0;
+		}
+		//any other block size has to be set with AL_SOFT_block_alignment
+		if (framesPerBlock != defaultFrames &&
+			!alIsExtensionPresent("AL_SOFT_block_alignment")) {
+			return 0;
+		}
+		return alGetEnumValue(formats[nchannels - 1]);
+	}
 };
 /*****************************************************************************/  
 //EOF                                                                         |
@@ -61,6 +61,22 @@ namespace kz {
 		static Int32 GetFormat(Uint32 channels);
 
 
+		/** returns the OpenAL format for float32 samples with the given
+			number of channels, or zero if AL_EXT_FLOAT32 is missing.
+			needs a current context.*/
+		static Int32 GetFloatFormat(Uint32 channels);
+
+
+		/** returns the OpenAL format for block-compressed samples, or zero
+			if the device can't take the encoding as-is and it has to be
+			decoded. needs a current context.
+			@param encoding:       IMA4 or MS-ADPCM
+			@param channels:       channel count, mono or stereo
+			@param framesPerBlock: frames held by each block*/
+		static Int32 GetEncodedFormat(AUDIOENCODING encoding,
+			Uint32 channels, Uint32 framesPerBlock);
+
+
 	private:
 		Bool                      m_initialized;
 		Float                     m_globalVolume;
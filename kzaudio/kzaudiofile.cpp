@@ -18,14 +18,18 @@
 | You should have received a copy of the GNU General Public License			  |
 | along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
 ******************************************************************************/ 
+#include <iostream>
 #include "kzaudiodecoder.h"
 #include "kzaudiodevice.h"
 #include "kzaudiofile.h"
 namespace kz {
 
+#define AUDIOFILE_ARENABLOCK 0x400 //fits the iobuf and any built-in decoder
 
 
-	AudioFile::AudioFile() {
+
+	AudioFile::AudioFile() :
+		m_arena(AUDIOFILE_ARENABLOCK) {
 		m_decoder      = NULL;
 		m_iobuf        = NULL;
 		m_iobufOwned   = false;
@@ -44,21 +48,75 @@ namespace kz {
 
 
 	Bool AudioFile::Load(const String& filename) {
-		AudioDesc info;
+		Close();
+
+		m_iobuf = m_arena.Create<IObuf>();
+		m_iobufOwned = true;
+
+		if (!m_iobuf || !m_iobuf->OpenMapped(filename)) {
+			Close();
+			return false;
+		}
+		m_decoder = CreateAudioDecoder(m_iobuf, &m_arena);
+		if (!m_decoder) {
+			std::cout << "failed to read audio file: " << filename
+			          << ".\n format is not supported" << std::endl;
+			Close();
+			return false;
+		}
+		return Initialize();
+	}
+
 
+
+	Bool AudioFile::Load(Lpcvoid data, SizeT nbytes) {
 		Close();
 
-		m_decoder = CreateAudioDecoder(filename);
+		m_iobuf = m_arena.Create<IObuf>();
+		m_iobufOwned = true;
+
+		if (!m_iobuf || !m_iobuf->OpenMemory(data, (Int64)(nbytes))) {
+			Close();
+			return false;
+		}
+		m_decoder = CreateAudioDecoder(m_iobuf, &m_arena);
 		if (!m_decoder) {
+			Close();
 			return false;
 		}
-		m_iobuf = new IObuf();
+		return Initialize();
+	}
+
+
+
+	Bool AudioFile::Load(IOStream* stream) {
+		Close();
+
+		m_iobuf = m_arena.Create<IObuf>();
 		m_iobufOwned = true;
 
-		if (!m_iobuf->Open(filename)) {
+		if (!m_iobuf) {
+			delete stream;
 			Close();
 			return false;
 		}
+		if (!m_iobuf->Open(stream, true)) {
+			Close();
+			return false;
+		}
+		m_decoder = CreateAudioDecoder(m_iobuf, &m_arena);
+		if (!m_decoder) {
+			Close();
+			return false;
+		}
+		return Initialize();
+	}
+
+
+
+	Bool AudioFile::Initialize() {
+		AudioDesc info;
+
 		if (!m_decoder->Open(m_iobuf, &info)) {
 			Close();
 			return false;
@@ -99,18 +157,32 @@ namespace kz {
 
 
 
+	Bool AudioFile::SupportsFloat() const {
+		return m_decoder && m_decoder->SupportsFloat();
+	}
+
+
+
+	Uint64 AudioFile::ReadFloat(Float* samples, Uint64 maxCount) {
+		Uint64 readSamples = 0;
+		if (m_decoder && samples && maxCount)
+			readSamples = m_decoder->ReadFloat(samples, maxCount);
+		m_sampleOffset += readSamples;
+		return readSamples;
+	}
+
+
+
 	Void AudioFile::Close() {
 		if (m_decoder) {
-			delete m_decoder;
+			ScratchArena::Destroy(m_decoder);
 			m_decoder = NULL;
 		}
 		if (m_iobufOwned && m_iobuf != NULL) {
 			m_iobufOwned = false;
-			if (m_iobuf) {
-				delete m_iobuf;
-				m_iobuf = NULL;
-			} 
+			ScratchArena::Destroy(m_iobuf);
 		}
+		m_arena.Reset();
 		m_iobuf        = NULL;
 		m_sampleOffset = 0;
 		m_sampleCount  = 0;
@@ -120,12 +192,61 @@ namespace kz {
 
 
 
+	const Int16* AudioFile::GetDirectSamples() const {
+		return m_decoder ? m_decoder->GetDirectSamples() : NULL;
+	}
+
+
+
+	AUDIOENCODING AudioFile::GetEncoding(Uint32* framesPerBlock,
+		Uint64* nbytes) const {
+		if (!m_decoder)
+			return AUDIOENCODING_PCM16;
+		return m_decoder->GetEncoding(framesPerBlock, nbytes);
+	}
+
+
+
+	Bool AudioFile::ReadEncoded(Byte* data) {
+		return m_decoder && m_decoder->ReadEncoded(data);
+	}
+
+
+
+	Bool AudioFile::SupportsSegments() const {
+		return m_decoder && m_decoder->SupportsSegments();
+	}
+
+
+
+	Bool AudioFile::GetLoopPoints(Uint64* start, Uint64* end) const {
+		return m_decoder && m_decoder->GetLoopPoints(start, end);
+	}
+
+
+
+	Lpcvoid AudioFile::GetData(SizeT* nbytes) const {
+		Int64 size = 0;
+		const Byte* data = m_iobuf ? m_iobuf->GetData(&size) : NULL;
+		*nbytes = (SizeT)(size);
+		return data;
+	}
+
+
+
 	Void AudioFile::GetDesc(AudioDesc* desc) const {
 		desc->sampleCount  = m_sampleCount;
 		desc->nchannels    = m_nchannels;
 		desc->sampleRate   = m_sampleRate;
 		desc->sampleOffset = m_sampleOffset;
 
+		Uint64 loopStart = 0, loopEnd = 0;
+		desc->loopEnabled = m_sampleRate != 0 && GetLoopPoints(&loopStart, &loopEnd);
+		desc->loopStart   = desc->loopEnabled ? TimeValue::FromSeconds(
+			(Float)(loopStart) / (Float)(m_sampleRate)) : TimeValue();
+		desc->loopEnd     = desc->loopEnabled ? TimeValue::FromSeconds(
+			(Float)(loopEnd) / (Float)(m_sampleRate)) : TimeValue();
+
 		if (m_nchannels == 0 || m_sampleRate == 0)
 			desc->length = TimeValue();
 		else {
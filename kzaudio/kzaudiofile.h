@@ -28,7 +28,7 @@ namespace kz {
 
 	/**
 	provides read access to audio files*/
-	class AudioFile {
+	class AudioFile : public Allocated {
 	public:
 
 		/** Construct AudioFile instance*/
@@ -37,11 +37,27 @@ namespace kz {
 
 
 		/**	open a file for reading.
-			Supports formats WAV (PCM only) and OGG/Vorbis.
+			Supports formats WAV (PCM, IMA4 and MS-ADPCM), OGG/Vorbis, Opus
+			and FLAC.
 			@return: true if the file was successfully opened, else false*/
 		Bool Load(const String& filename);
 
 
+		/**	open an audio file held in memory. the data is read in
+			place, it is not copied and must remain valid until the
+			file is closed or another file is loaded.
+			@param data:   start of the encoded file contents
+			@param nbytes: size of the file contents in bytes
+			@return: true if the file was successfully opened, else false*/
+		Bool Load(Lpcvoid data, SizeT nbytes);
+
+
+		/**	open an audio file read from any stream backend
+			@param stream: source of the encoded file [TAKES OWNERSHIP]
+			@return: true if the file was successfully opened, else false*/
+		Bool Load(IOStream* stream);
+
+
 		/**	read audio samples from the open file-
 			@psamples: sample array to fill
 			@nsamples: max number of samples to read
@@ -49,6 +65,17 @@ namespace kz {
 		Uint64 Read(Int16* psamples, Uint64 nsamples);
 
 
+		/**	returns true if the file can be read as float samples*/
+		Bool SupportsFloat() const;
+
+
+		/**	read audio samples as float in [-1, 1], see SupportsFloat-
+			@psamples: sample array to fill
+			@nsamples: max number of samples to read
+			@return  : samples read (may be less than nsamples)*/
+		Uint64 ReadFloat(Float* psamples, Uint64 nsamples);
+
+
 		/**	set the read position to the given offset*/
 		Void Seek(Uint64 offset);
 
@@ -66,7 +93,53 @@ namespace kz {
 		Void GetDesc(AudioDesc* desc) const;
 
 
+		/**	get all of the file's samples without decoding, possible for
+			16-bit pcm files that are mapped or held in memory.
+			@return: the samples, valid until the file is closed,
+			         or null if they have to be read*/
+		const Int16* GetDirectSamples() const;
+
+
+		/**	get the block encoding the file's samples can be uploaded in
+			without decoding (IMA4 or MS-ADPCM wav files)
+			@param framesPerBlock: receives the frames held by each block
+			@param nbytes:         receives the size of the encoded data
+			@return: the encoding, AUDIOENCODING_PCM16 if it must be decoded*/
+		AUDIOENCODING GetEncoding(Uint32* framesPerBlock, Uint64* nbytes) const;
+
+
+		/**	read all of the encoded sample data, see GetEncoding
+			@param data: receives nbytes of encoded blocks
+			@return: true if the data was read*/
+		Bool ReadEncoded(Byte* data);
+
+
+		/**	returns true if ranges of the file can be decoded separately,
+			see GetData. each range is read by its own AudioFile opened
+			over the same data, seeked to the first sample of the range.*/
+		Bool SupportsSegments() const;
+
+
+		/**	get the encoded contents of a file that is mapped or held
+			in memory, to open more AudioFiles over the same data
+			@param nbytes: receives the size of the contents in bytes
+			@return: the contents, valid until the file is closed,
+			         or null if the file is read from a stream*/
+		Lpcvoid GetData(SizeT* nbytes) const;
+
+
+		/**	get the loop stored in the file's metadata, from the WAV smpl
+			chunk or the LOOPSTART/LOOPLENGTH comments of other formats
+			@param start: receives the first frame of the loop
+			@param end:   receives the frame after the last one of the loop
+			@return: false if the file defines no loop*/
+		Bool GetLoopPoints(Uint64* start, Uint64* end) const;
+
+
 	private:
+		Bool Initialize();
+
+		ScratchArena  m_arena;   //holds the decoder and the owned iobuf
 		AudioDecoder* m_decoder;
 		IObuf*        m_iobuf;
 		Bool          m_iobufOwned;
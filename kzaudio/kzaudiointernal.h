@@ -22,23 +22,36 @@
 #define __KZAUDIOINTERNAL_H__
  
 #include <unordered_set> 
+#include "kzallocator.h"
 #include "kztimevalue.h"
 #include "kziobuf.h" 
 namespace kz {
 
 
+	class AsyncLoader;
 	class AudioDecoder;
+	class AudioDecoderFLAC;
 	class AudioDecoderOGG;
+	class AudioDecoderOpus;
 	class AudioDecoderWAV;
 	class AudioDevice;
 	class AudioFile;
 	class MusicStream;
+	class ResidencyManager;
 	class Sound;
 	class SoundBuffer;
 
-	typedef std::vector<Int16> SAMPLEDATA;
+	typedef std::vector<Int16, StlAllocator<Int16>> SAMPLEDATA;
+	typedef std::vector<Float, StlAllocator<Float>> FLOATDATA;
 	typedef const Int16*       SAMPLESPTR;
 
+	/** encodings sample data can be held and uploaded in*/
+	enum AUDIOENCODING {
+		AUDIOENCODING_PCM16,   //signed 16-bit pcm
+		AUDIOENCODING_IMA4,    //IMA4 adpcm blocks (AL_EXT_IMA4)
+		AUDIOENCODING_MSADPCM  //Microsoft adpcm blocks (AL_SOFT_MSADPCM)
+	};
+
 	struct Chunk {
 		SAMPLESPTR samples;     //Pointer to the audio samples
 		SizeT      sampleCount; //Number of samples pointed by Samples
@@ -50,9 +63,9 @@ namespace kz {
 	struct AudioDesc {
 		Uint32     nchannels;    //channel count. 1 (mono), 2 (stereo) 
 		TimeValue  length;       //total duration of the audio
-		Bool       loopEnabled;  //stream is looping?
+		Bool       loopEnabled;  //file defines a loop?
 		TimeValue  loopStart;    //The beginning offset 
-		TimeValue  loopEnd;      //The length of the loop
+		TimeValue  loopEnd;      //The end offset of the loop
 		TimeValue  position;     //current playing position (from beginning) 
 		SAMPLESPTR samples;      //array of audio samples stored in the buffer
 		Uint64     sampleCount;  //total number of audio samples in the file 
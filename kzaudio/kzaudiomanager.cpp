@@ -63,6 +63,9 @@ bool AudioManager::Initialize(const std::string& directory) {
 	if (m_initialized) {
 		return true;
 	}
+	//packed assets are optional, loose files are used when absent:
+	m_pack.Open(m_directory + "audio.kzpak");
+
 	//create and initialize OpenAL device:
 	m_audioDevice = new kz::AudioDevice();
 	if (!m_audioDevice ||
@@ -130,12 +133,22 @@ bool AudioManager::LoadSound(SOUNDID id) {
 	if (!m_sounds[id]) {
 		return false;
 	}
-	pathToFile = m_directory + GetSoundFileName(id);
-	if (!m_sounds[id]->buffer.Load(pathToFile)) {
+	const kz::Byte* data;
+	size_t          nbytes;
+	if (m_pack.Find(GetSoundFileName(id), &data, &nbytes)) {
+		//the pack stays open while sounds are loaded, they reload from it
+		m_sounds[id]->buffer = m_buffers.LoadMapped(GetSoundFileName(id), data, nbytes);
+	}
+	else {
+		pathToFile = m_directory + GetSoundFileName(id);
+		m_sounds[id]->buffer = m_buffers.Load(pathToFile);
+	}
+	if (!m_sounds[id]->buffer.IsValid()) {
 		UnloadSound(id);
 		return false;
 	} 
-	m_sounds[id]->sound.SetBuffer(&m_sounds[id]->buffer);
+	m_residency.Add(m_sounds[id]->buffer.Get());
+	m_sounds[id]->sound.SetBuffer(m_sounds[id]->buffer.Get());
 	m_sounds[id]->sound.SetInitialVolume(100);
 	m_sounds[id]->sound.SetVolume(100);
 
@@ -175,6 +188,12 @@ void AudioManager::StopAllSounds() {
 
 
 
+void AudioManager::SetSoundBudget(size_t nbytes) {
+	m_residency.SetBudget(nbytes);
+}
+
+
+
 void AudioManager::UnloadAllSounds() {
 	for (int i = 0; i < SOUNDID_UNDEFINED; ++i) {
 		UnloadSound((SOUNDID)i);
@@ -225,8 +244,17 @@ bool AudioManager::LoadMusic(MUSICID mus) {
 		}
 		m_music->Stop(); 
 		 
-		std::string pathToFile = m_directory + GetMusicFileName(mus);  
-		if (!m_music->Load(pathToFile)) {
+		const kz::Byte* data;
+		size_t          nbytes;
+		bool            loaded;
+		if (m_pack.Find(GetMusicFileName(mus), &data, &nbytes)) {
+			loaded = m_music->Load(data, nbytes);
+		}
+		else {
+			std::string pathToFile = m_directory + GetMusicFileName(mus);  
+			loaded = m_music->Load(pathToFile);
+		}
+		if (!loaded) {
 			return false;
 		} 
 	}
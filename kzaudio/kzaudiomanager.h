@@ -25,7 +25,10 @@
 #define __AUDIOMANAGER_H__
 
 #include "kzglobalinstance.h" 
+#include "kzaudiopack.h"
+#include "kzbuffercache.h"
 #include "kzmusicstream.h"
+#include "kzresidency.h"
 #include "kzaudiodevice.h" 
 #include "kzsoundbuffer.h"
 #include "kzsound.h" 
@@ -64,6 +67,8 @@ public:
 
 	/** initialize the audio system.
 		this function must be called once before using audio.
+		if the directory holds an "audio.kzpak" archive, files are
+		read from it first and only looked up on disk if missing.
 		@param directory: the directory containing audio files*/
 	bool Initialize(const std::string& directory);
 
@@ -101,6 +106,12 @@ public:
 	/** stops playback of all sounds*/
 	void StopAllSounds();
 
+	/**	set the memory loaded sound effects may hold. the least recently
+		played sounds are unloaded past it, and loaded again when played,
+		from their file or their entry of audio.kzpak.
+		@param nbytes: cpu and device bytes, KZRESIDENCY_BUDGET by default*/
+	void SetSoundBudget(size_t nbytes);
+
 
 	/**	play a sound effect (must be currently loaded)
 		@param id: enum value identifying the sound
@@ -173,8 +184,8 @@ private:
 	std::string GetMusicFileName(MUSICID id);
 
 	struct SoundEffect {
-		kz::SoundBuffer buffer;
-		kz::Sound       sound;
+		kz::BufferHandle buffer;  //shared with other sounds of the same file
+		kz::Sound        sound;
 	};
 	bool             m_initialized;
 	int              m_globalVolume;
@@ -182,6 +193,9 @@ private:
 	MUSICID          m_currentMusic;
 	bool             m_soundEnabled;
 	bool             m_musicEnabled;
+	kz::AudioPack    m_pack;
+	kz::ResidencyManager m_residency; //declared first, it outlives the buffers
+	kz::BufferCache  m_buffers;
 	kz::AudioDevice* m_audioDevice;
 	kz::MusicStream* m_music;
 	SoundEffect*     m_sounds[SOUNDID_UNDEFINED];
@@ -0,0 +1,319 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzaudiopack.cpp												          |
+| Desc: packed audio archives (.kzpak) with a hashed name index               |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#include <algorithm>
+#include "kzaudiopack.h"
+namespace kz {
+
+#define KZPAK_MAGIC      "KZPK"
+#define KZPAK_HEADERSIZE 32
+#define KZPAK_ENTRYSIZE  24
+
+
+
+	/** read a little-endian 32-bit value*/
+	static Uint32 Read32(const Byte* bytes) {
+		return (Uint32)(bytes[0]) |
+			((Uint32)(bytes[1]) << 0x08) |
+			((Uint32)(bytes[2]) << 0x10) |
+			((Uint32)(bytes[3]) << 0x18);
+	}
+
+
+
+	/** read a little-endian 64-bit value*/
+	static Uint64 Read64(const Byte* bytes) {
+		return (Uint64)(Read32(bytes)) | ((Uint64)(Read32(bytes + 4)) << 0x20);
+	}
+
+
+
+	/** write a little-endian 32-bit value*/
+	static Void Write32(Byte* bytes, Uint32 value) {
+		bytes[0] = (Byte)(value);
+		bytes[1] = (Byte)(value >> 0x08);
+		bytes[2] = (Byte)(value >> 0x10);
+		bytes[3] = (Byte)(value >> 0x18);
+	}
+
+
+
+	/** write a little-endian 64-bit value*/
+	static Void Write64(Byte* bytes, Uint64 value) {
+		Write32(bytes, (Uint32)(value));
+		Write32(bytes + 4, (Uint32)(value >> 0x20));
+	}
+
+
+
+	/** round a file offset up to the entry alignment*/
+	static Uint64 AlignOffset(Uint64 offset) {
+		return (offset + KZPAK_ALIGNMENT - 1) & ~(Uint64)(KZPAK_ALIGNMENT - 1);
+	}
+
+
+
+	Uint64 AudioPack::HashName(const String& name) {
+		Uint64 hash = 0xCBF29CE484222325ULL;
+		SizeT  i    = 0;
+
+		//normalize as we go: skip leading "./" and "/", fold case and slashes
+		while (i < name.size()) {
+			if (name[i] == '/' || name[i] == '\\')
+				++i;
+			else if (name[i] == '.' && i + 1 < name.size() &&
+				(name[i + 1] == '/' || name[i + 1] == '\\'))
+				i += 2;
+			else break;
+		}
+		for (; i < name.size(); ++i) {
+			Char c = name[i] == '\\' ? '/' : (Char)(tolower((Uchar)(name[i])));
+			hash ^= (Uchar)(c);
+			hash *= 0x100000001B3ULL;
+		}
+		return hash;
+	}
+	/**************************************************************************
+	**************************************************************************/
+
+
+
+
+
+	/**************************************************************************
+	**************************************************************************/
+	AudioPack::AudioPack() {
+		m_file  = NULL;
+		m_data  = NULL;
+		m_size  = 0;
+		m_count = 0;
+	}
+
+
+
+	AudioPack::~AudioPack() {
+		Close();
+	}
+
+
+
+	Bool AudioPack::Open(const String& path) {
+		Close();
+
+		m_file = OpenMappedStream(path);
+		if (m_file) {
+			m_data = m_file->GetData();
+			m_size = m_file->GetSize();
+		}
+		else {
+			//no mmap, read the whole archive into memory once
+			IObuf iobuf;
+			if (!iobuf.Open(path)) {
+				return false;
+			}
+			Int64 size = iobuf.GetSize();
+			if (size <= 0) {
+				return false;
+			}
+			m_memory.resize((SizeT)(size));
+			if (iobuf.Read(m_memory.data(), size) != size) {
+				Close();
+				return false;
+			}
+			m_data = m_memory.data();
+			m_size = size;
+		}
+		if (m_size < KZPAK_HEADERSIZE ||
+			memcmp(m_data, KZPAK_MAGIC, 4) != 0 ||
+			Read32(m_data + 4) != KZPAK_VERSION) {
+			Close();
+			return false;
+		}
+		m_count = Read32(m_data + 8);
+		if (KZPAK_HEADERSIZE + (Int64)(m_count) * KZPAK_ENTRYSIZE > m_size) {
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+
+
+	Void AudioPack::Close() {
+		if (m_file) {
+			delete m_file;
+			m_file = NULL;
+		}
+		BYTEDATA().swap(m_memory);
+		m_data  = NULL;
+		m_size  = 0;
+		m_count = 0;
+	}
+
+
+
+	Bool AudioPack::IsOpen() const {
+		return m_data != NULL;
+	}
+
+
+
+	SizeT AudioPack::GetEntryCount() const {
+		return m_count;
+	}
+
+
+
+	Bool AudioPack::Find(const String& name, const Byte** data, SizeT* nbytes) const {
+		const Byte* index = m_data + KZPAK_HEADERSIZE;
+		Uint64      hash  = HashName(name);
+		SizeT       low   = 0;
+		SizeT       high  = m_count;
+
+		while (low < high) {
+			SizeT       middle = low + (high - low) / 2;
+			const Byte* entry  = index + middle * KZPAK_ENTRYSIZE;
+			Uint64      key    = Read64(entry);
+
+			if (key < hash) {
+				low = middle + 1;
+			}
+			else if (key > hash) {
+				high = middle;
+			}
+			else {
+				Uint64 offset = Read64(entry + 8);
+				Uint64 size   = Read64(entry + 16);
+				if (offset > (Uint64)(m_size) || size > (Uint64)(m_size) - offset) {
+					return false;
+				}
+				*data   = m_data + offset;
+				*nbytes = (SizeT)(size);
+				return true;
+			}
+		}
+		return false;
+	}
+
+
+
+	Bool AudioPack::Open(const String& name, IObuf* iobuf) const {
+		const Byte* data;
+		SizeT       nbytes;
+		if (!Find(name, &data, &nbytes)) {
+			return false;
+		}
+		return iobuf->OpenMemory(data, (Int64)(nbytes));
+	}
+	/**************************************************************************
+	**************************************************************************/
+
+
+
+
+
+	/**************************************************************************
+	**************************************************************************/
+	Void AudioPackWriter::AddFile(const String& name, const String& path) {
+		Entry entry = { name, path };
+		m_entries.push_back(entry);
+	}
+
+
+
+	Bool AudioPackWriter::Write(const String& path) const {
+		struct Record {
+			Uint64 hash;
+			Uint64 offset;
+			Uint64 size;
+			SizeT  entry;
+		};
+		std::vector<Record> records(m_entries.size());
+
+		for (SizeT i = 0; i < m_entries.size(); ++i) {
+			StdioStream file;
+			if (!file.Open(m_entries[i].path)) {
+				return false;
+			}
+			records[i].hash  = AudioPack::HashName(m_entries[i].name);
+			records[i].size  = (Uint64)(file.GetSize());
+			records[i].entry = i;
+		}
+		std::sort(records.begin(), records.end(),
+			[](const Record& a, const Record& b) { return a.hash < b.hash; });
+
+		Uint64 offset = AlignOffset(KZPAK_HEADERSIZE +
+			(Uint64)(records.size()) * KZPAK_ENTRYSIZE);
+		for (SizeT i = 0; i < records.size(); ++i) {
+			if (i > 0 && records[i].hash == records[i - 1].hash) {
+				return false;//name collision, lookups would be ambiguous
+			}
+			records[i].offset = offset;
+			offset = AlignOffset(offset + records[i].size);
+		}
+
+		std::vector<Byte> index(KZPAK_HEADERSIZE + records.size() * KZPAK_ENTRYSIZE);
+		memcpy(index.data(), KZPAK_MAGIC, 4);
+		Write32(&index[4], KZPAK_VERSION);
+		Write32(&index[8], (Uint32)(records.size()));
+		Write32(&index[12], KZPAK_ALIGNMENT);
+		for (SizeT i = 0; i < records.size(); ++i) {
+			Byte* entry = &index[KZPAK_HEADERSIZE + i * KZPAK_ENTRYSIZE];
+			Write64(entry, records[i].hash);
+			Write64(entry + 8, records[i].offset);
+			Write64(entry + 16, records[i].size);
+		}
+
+		FILE* output = fopen(path.c_str(), "wb");
+		if (!output) {
+			return false;
+		}
+		Bool              success  = fwrite(index.data(), 1, index.size(), output) == index.size();
+		Uint64            position = index.size();
+		std::vector<Byte> buffer(0x10000);
+
+		for (SizeT i = 0; success && i < records.size(); ++i) {
+			//pad up to the entry's page boundary
+			std::vector<Byte> padding((SizeT)(records[i].offset - position), 0);
+			success = fwrite(padding.data(), 1, padding.size(), output) == padding.size();
+			position = records[i].offset;
+
+			StdioStream file;
+			Uint64      remaining = records[i].size;
+			success = success && file.Open(m_entries[records[i].entry].path);
+			while (success && remaining > 0) {
+				Int64 count = file.Read(buffer.data(),
+					(Int64)(Min<Uint64>(remaining, buffer.size())));
+				success = count > 0 &&
+					fwrite(buffer.data(), 1, (SizeT)(count), output) == (SizeT)(count);
+				remaining -= success ? (Uint64)(count) : 0;
+				position  += success ? (Uint64)(count) : 0;
+			}
+		}
+		success = (fclose(output) == 0) && success;
+		if (!success) {
+			remove(path.c_str());
+		}
+		return success;
+	}
+};
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/
@@ -0,0 +1,128 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzaudiopack.h												          |
+| Desc: packed audio archives (.kzpak) with a hashed name index               |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#ifndef __KZAUDIOPACK_H__
+#define __KZAUDIOPACK_H__
+
+#include <vector>
+#include "kziobuf.h"
+/**
+layout of a .kzpak file, all integers little-endian:
+
+  header  (32 bytes)  magic "KZPK", version, entry count, entry alignment,
+                      16 reserved bytes
+  index   (24 bytes per entry, sorted by hash)
+                      64-bit name hash, 64-bit offset, 64-bit size
+  entries             file contents, each starting on an alignment boundary
+
+names are hashed with 64-bit FNV-1a after normalizing them (lower case,
+forward slashes, no leading "./" or "/").*/
+#define KZPAK_VERSION   1
+#define KZPAK_ALIGNMENT 0x1000
+namespace kz {
+
+
+
+	/**
+	read access to a packed audio archive. the archive is memory mapped
+	where possible (otherwise read into memory once) and entries are
+	handed out as views into it, so no file is opened per asset.*/
+	class AudioPack final : NonCopyable {
+	public:
+		AudioPack();
+		~AudioPack();
+
+
+		/**	open an archive
+			@param path: path/name of the .kzpak file
+			@return:     true on success, false on error*/
+		Bool Open(const String& path);
+
+
+		/** close the archive. views and streams handed out become invalid*/
+		Void Close();
+
+
+		/** returns true if an archive is open*/
+		Bool IsOpen() const;
+
+
+		/** returns the number of entries in the archive*/
+		SizeT GetEntryCount() const;
+
+
+		/**	find the contents of an entry
+			@param name:   name the entry was packed under
+			@param data:   receives a pointer to the entry contents
+			@param nbytes: receives the size of the entry in bytes
+			@return:       true if found, else false*/
+		Bool Find(const String& name, const Byte** data, SizeT* nbytes) const;
+
+
+		/**	open an entry as a stream, reading in place from the archive
+			@param name:  name the entry was packed under
+			@param iobuf: stream to open
+			@return:      true if found, else false*/
+		Bool Open(const String& name, IObuf* iobuf) const;
+
+
+		/** returns the index hash of an entry name*/
+		static Uint64 HashName(const String& name);
+
+
+	private:
+		IOStream*         m_file;    //mapping of the archive, if mapped
+		BYTEDATA          m_memory;  //archive contents, if not mapped
+		const Byte*       m_data;    //start of the archive
+		Int64             m_size;    //size of the archive in bytes
+		SizeT             m_count;   //number of index entries
+	};
+
+
+
+	/**
+	builds packed audio archives*/
+	class AudioPackWriter final : NonCopyable {
+	public:
+
+		/**	queue a file to be packed
+			@param name: name the entry is looked up by
+			@param path: path of the file to read the contents from*/
+		Void AddFile(const String& name, const String& path);
+
+
+		/**	write the archive
+			@param path: path/name of the .kzpak file to create
+			@return:     true on success, false on error (missing files,
+			             i/o errors or two names with the same hash)*/
+		Bool Write(const String& path) const;
+
+
+	private:
+		struct Entry {
+			String name;
+			String path;
+		};
+		std::vector<Entry> m_entries;
+	};
+};
+/*****************************************************************************/
+#endif//EOF                                                                   |
+/*****************************************************************************/
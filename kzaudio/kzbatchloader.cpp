@@ -0,0 +1,230 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzbatchloader.cpp											          |
+| Desc: loads many sound buffers with all file reads in flight at once        |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#include <deque>
+#include "kzbatchloader.h"
+#include "kzsoundbuffer.h"
+#include "kzthreadpool.h"
+#if (KZBATCHLOADER_USING_IOURING)
+#  include <fcntl.h>
+#  include <stdint.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  include <liburing.h>
+#endif
+namespace kz {
+
+
+
+	BatchLoader::BatchLoader() {
+		m_queueDepth = 64;
+	}
+
+
+
+	Void BatchLoader::Add(const String& path, SoundBuffer* buffer) {
+		Request request = { path, buffer };
+		m_requests.push_back(request);
+	}
+
+
+
+	Void BatchLoader::Clear() {
+		m_requests.clear();
+	}
+
+
+
+	SizeT BatchLoader::GetCount() const {
+		return m_requests.size();
+	}
+
+
+
+	Void BatchLoader::SetQueueDepth(Uint32 depth) {
+		m_queueDepth = Max<Uint32>(depth, 1);
+	}
+
+
+
+	SizeT BatchLoader::Load(BATCHPROC callback, Lpvoid user) {
+		Int64 loaded = -1;
+	#if (KZBATCHLOADER_USING_IOURING) && !(KZIOBUF_USING_PHYSFS)
+		//the ring reads native paths, so only use it with the default opener
+		if (!IObuf::GetFileOpener()) {
+			loaded = LoadUring(callback, user);
+		}
+	#endif
+		if (loaded < 0) {
+			loaded = (Int64)(LoadThreaded(callback, user));
+		}
+		m_requests.clear();
+		return (SizeT)(loaded);
+	}
+
+
+
+	Bool BatchLoader::Finish(SizeT index, Bool read, FILEDATA& data,
+		BATCHPROC callback, Lpvoid user) {
+		Request& request = m_requests[index];
+		Bool     loaded  = read && !data.empty() &&
+			request.buffer->Load(request.path, data.data(), data.size());
+
+		FILEDATA().swap(data);
+		if (callback) {
+			callback(request.buffer, request.path, loaded, user);
+		}
+		return loaded;
+	}
+
+
+
+	SizeT BatchLoader::LoadThreaded(BATCHPROC callback, Lpvoid user) {
+		const SizeT             count = m_requests.size();
+		std::vector<FILEDATA>   files(count);
+		std::vector<Bool>       reads(count, false);
+		std::deque<SizeT>       completed;
+		std::mutex              mutex;
+		std::condition_variable ready;
+		SizeT                   loaded = 0;
+
+		if (count == 0) {
+			return 0;
+		}
+		ThreadPool pool((Uint32)(Min<SizeT>(count, m_queueDepth)));
+		for (SizeT i = 0; i < count; ++i) {
+			pool.Submit([&, i]() {
+				IOStream* stream = IObuf::CreateStream(m_requests[i].path);
+				Bool      read   = false;
+				if (stream) {
+					Int64 size = stream->GetSize();
+					if (size > 0) {
+						files[i].resize((SizeT)(size));
+						read = stream->Read(files[i].data(), size) == size;
+					}
+					delete stream;
+				}
+				std::lock_guard<std::mutex> lock(mutex);
+				reads[i] = read;
+				completed.push_back(i);
+				ready.notify_one();
+			});
+		}
+		//decode on this thread in completion order
+		for (SizeT finished = 0; finished < count; ++finished) {
+			SizeT index;
+			Bool  read;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while (completed.empty())
+					ready.wait(lock);
+				index = completed.front();
+				read  = reads[index];
+				completed.pop_front();
+			}
+			loaded += Finish(index, read, files[index], callback, user) ? 1 : 0;
+		}
+		return loaded;
+	}
+
+
+
+#if (KZBATCHLOADER_USING_IOURING)
+	Int64 BatchLoader::LoadUring(BATCHPROC callback, Lpvoid user) {
+		struct Pending {
+			Int32    fd;
+			FILEDATA data;
+			SizeT    done;
+		};
+		const SizeT          count = m_requests.size();
+		std::vector<Pending> pending(count);
+		struct io_uring      ring;
+		SizeT                next     = 0;
+		SizeT                inflight = 0;
+		SizeT                loaded   = 0;
+
+		if (io_uring_queue_init(m_queueDepth, &ring, 0) < 0) {
+			return -1;
+		}
+		while (next < count || inflight > 0) {
+			//keep the ring full
+			while (next < count && inflight < m_queueDepth) {
+				Pending&    file = pending[next];
+				struct stat info;
+
+				file.done = 0;
+				file.fd   = open(m_requests[next].path.c_str(), O_RDONLY);
+				if (file.fd == -1 || fstat(file.fd, &info) != 0 || info.st_size <= 0) {
+					if (file.fd != -1)
+						close(file.fd);
+					Finish(next++, false, file.data, callback, user);
+					continue;
+				}
+				file.data.resize((SizeT)(info.st_size));
+
+				struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+				io_uring_prep_read(sqe, file.fd, file.data.data(),
+					(Uint32)(file.data.size()), 0);
+				io_uring_sqe_set_data(sqe, (Lpvoid)(uintptr_t)(next));
+				++next;
+				++inflight;
+			}
+			if (inflight == 0) {
+				continue;
+			}
+			io_uring_submit_and_wait(&ring, 1);
+
+			//decode whatever has arrived, the rest keeps reading meanwhile
+			struct io_uring_cqe* cqe;
+			while (io_uring_peek_cqe(&ring, &cqe) == 0) {
+				SizeT    index  = (SizeT)(uintptr_t)(io_uring_cqe_get_data(cqe));
+				Int32    result = cqe->res;
+				Pending& file   = pending[index];
+				io_uring_cqe_seen(&ring, cqe);
+
+				if (result > 0) {
+					file.done += (SizeT)(result);
+					if (file.done < file.data.size()) {
+						//short read, queue the remainder
+						struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+						io_uring_prep_read(sqe, file.fd, file.data.data() + file.done,
+							(Uint32)(file.data.size() - file.done), (Uint64)(file.done));
+						io_uring_sqe_set_data(sqe, (Lpvoid)(uintptr_t)(index));
+						continue;
+					}
+				}
+				--inflight;
+				close(file.fd);
+				loaded += Finish(index, file.done == file.data.size(),
+					file.data, callback, user) ? 1 : 0;
+			}
+		}
+		io_uring_queue_exit(&ring);
+		return (Int64)(loaded);
+	}
+#else
+	Int64 BatchLoader::LoadUring(BATCHPROC, Lpvoid) {
+		return -1;
+	}
+#endif
+};
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/
@@ -0,0 +1,101 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzbatchloader.h												          |
+| Desc: loads many sound buffers with all file reads in flight at once        |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#ifndef __KZBATCHLOADER_H__
+#define __KZBATCHLOADER_H__
+/**
+if this define is set to 1 (linux only, link with liburing), batches are
+read through io_uring. otherwise, or if the kernel refuses to create a
+ring, the reads are spread over a pool of worker threads*/
+#ifndef KZBATCHLOADER_USING_IOURING
+#  define KZBATCHLOADER_USING_IOURING 0
+#endif
+
+#include <vector>
+#include "kzaudiointernal.h"
+namespace kz {
+
+
+
+	/**
+	loads a list of sound buffers with all of their file reads issued up
+	front. each file is decoded and uploaded on the calling thread as soon
+	as its read completes, while the remaining reads are still in flight.*/
+	class BatchLoader final : NonCopyable {
+	public:
+
+		/** called on the loading thread once per queued file
+			@param buffer: the buffer that was being loaded
+			@param path:   path the buffer was loaded from
+			@param loaded: true if the buffer was loaded successfully
+			@param user:   the pointer given to Load*/
+		typedef Void (*BATCHPROC)(SoundBuffer* buffer, const String& path,
+			Bool loaded, Lpvoid user);
+
+
+		BatchLoader();
+
+
+		/**	queue a sound buffer to be loaded by the next Load call
+			@param path:   path/name of the file to load
+			@param buffer: buffer to load the sound data into*/
+		Void Add(const String& path, SoundBuffer* buffer);
+
+
+		/** remove all queued files*/
+		Void Clear();
+
+
+		/** returns the number of queued files*/
+		SizeT GetCount() const;
+
+
+		/**	set how many file reads may be in flight at once
+			(io_uring queue depth, or worker threads for the fallback)*/
+		Void SetQueueDepth(Uint32 depth);
+
+
+		/**	load every queued file, blocking until all are done. the
+			queue is emptied afterwards.
+			@param callback: optional, reports each file as it finishes
+			@param user:     passed back to the callback
+			@return:         number of buffers loaded successfully*/
+		SizeT Load(BATCHPROC callback = NULL, Lpvoid user = NULL);
+
+
+	private:
+		struct Request {
+			String       path;
+			SoundBuffer* buffer;
+		};
+		typedef BYTEDATA FILEDATA;
+
+		Int64 LoadUring(BATCHPROC callback, Lpvoid user);
+		SizeT LoadThreaded(BATCHPROC callback, Lpvoid user);
+		Bool  Finish(SizeT index, Bool read, FILEDATA& data,
+			BATCHPROC callback, Lpvoid user);
+
+		std::vector<Request> m_requests;
+		Uint32               m_queueDepth;
+	};
+};
+/*****************************************************************************/
+#endif//EOF                                                                   |
+/*****************************************************************************/
@@ -0,0 +1,287 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzbuffercache.cpp												          |
+| Desc: shared sound buffers keyed by path                                    |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#include <vector>
+#include "kzbuffercache.h"
+#include "kzsoundbuffer.h"
+namespace kz {
+
+
+
+	/**
+	a cached buffer and the handles referring to it*/
+	struct BufferCacheEntry : public Allocated {
+		BufferCache* cache;   //null once the cache is destroyed
+		String       key;
+		SoundBuffer  buffer;
+		Uint32       refs;
+		LOADSTATE    state;
+		AsyncLoader* loader;  //loader of a queued load, else null
+		LOADHANDLE   load;
+	};
+
+
+
+	BufferHandle::BufferHandle() :
+		m_entry(NULL) {
+	}
+
+	BufferHandle::BufferHandle(BufferCacheEntry* entry) :
+		m_entry(entry) {
+		if (m_entry)
+			++m_entry->refs;
+	}
+
+	BufferHandle::BufferHandle(const BufferHandle& copy) :
+		BufferHandle(copy.m_entry) {
+	}
+
+	BufferHandle& BufferHandle::operator=(const BufferHandle& copy) {
+		BufferHandle temp(copy);
+		std::swap(m_entry, temp.m_entry);
+		return *this;
+	}
+
+	BufferHandle::~BufferHandle() {
+		Release();
+	}
+
+
+
+	Void BufferHandle::Release() {
+		BufferCacheEntry* entry = m_entry;
+		m_entry = NULL;
+		if (!entry || --entry->refs != 0) {
+			return;
+		}
+		//the last reference, unload now rather than at some later point
+		if (entry->loader) {
+			entry->loader->Cancel(entry->load);
+		}
+		if (entry->cache) {
+			entry->cache->Remove(entry);
+		}
+		delete entry;
+	}
+
+
+
+	Bool BufferHandle::IsValid() const {
+		return m_entry != NULL;
+	}
+
+
+
+	Bool BufferHandle::IsLoaded() const {
+		return m_entry && m_entry->state == LOADSTATE_LOADED;
+	}
+
+
+
+	LOADSTATE BufferHandle::GetState() const {
+		if (!m_entry) {
+			return LOADSTATE_NONE;
+		}
+		return m_entry->loader ? m_entry->loader->GetState(m_entry->load) : m_entry->state;
+	}
+
+
+
+	SoundBuffer* BufferHandle::Get() const {
+		return m_entry ? &m_entry->buffer : NULL;
+	}
+
+
+
+	const String& BufferHandle::GetPath() const {
+		static const String empty;
+		return m_entry ? m_entry->key : empty;
+	}
+
+
+
+	BufferCache::BufferCache() {
+	}
+
+	BufferCache::~BufferCache() {
+		for (auto& entry : m_entries) {
+			entry.second->cache = NULL;
+		}
+	}
+
+
+
+	BufferCacheEntry* BufferCache::Acquire(const String& key, Bool* created) {
+		ENTRYMAP::iterator found = m_entries.find(key);
+		if (found != m_entries.end()) {
+			*created = false;
+			return found->second;
+		}
+		BufferCacheEntry* entry = new BufferCacheEntry();
+		entry->cache  = this;
+		entry->key    = key;
+		entry->refs   = 0;
+		entry->state  = LOADSTATE_NONE;
+		entry->loader = NULL;
+		entry->load   = 0;
+		m_entries[key] = entry;
+		*created = true;
+		return entry;
+	}
+
+
+
+	Void BufferCache::Remove(BufferCacheEntry* entry) {
+		m_entries.erase(entry->key);
+		entry->cache = NULL;
+	}
+
+
+
+	BufferHandle BufferCache::Load(const String& path) {
+		Bool              created;
+		BufferCacheEntry* entry = Acquire(NormalizePath(path), &created);
+		BufferHandle      handle(entry);
+
+		//failed loads are tried again, queued ones are returned as is. the
+		//key is only for lookups, openers may tell the case of paths apart
+		if (created || entry->state == LOADSTATE_FAILED) {
+			entry->state = entry->buffer.Load(path) ?
+				LOADSTATE_LOADED : LOADSTATE_FAILED;
+			if (entry->state == LOADSTATE_FAILED)
+				handle.Release();
+		}
+		return handle;
+	}
+
+
+
+	BufferHandle BufferCache::Load(const String& path, Lpcvoid data, SizeT nbytes) {
+		Bool              created;
+		BufferCacheEntry* entry = Acquire(NormalizePath(path), &created);
+		BufferHandle      handle(entry);
+
+		if (created || entry->state == LOADSTATE_FAILED) {
+			entry->state = entry->buffer.Load(data, nbytes) ?
+				LOADSTATE_LOADED : LOADSTATE_FAILED;
+			if (entry->state == LOADSTATE_FAILED)
+				handle.Release();
+		}
+		return handle;
+	}
+
+
+
+	BufferHandle BufferCache::LoadMapped(const String& path, Lpcvoid data, SizeT nbytes) {
+		Bool              created;
+		BufferCacheEntry* entry = Acquire(NormalizePath(path), &created);
+		BufferHandle      handle(entry);
+
+		if (created || entry->state == LOADSTATE_FAILED) {
+			entry->state = entry->buffer.LoadMapped(data, nbytes) ?
+				LOADSTATE_LOADED : LOADSTATE_FAILED;
+			if (entry->state == LOADSTATE_FAILED)
+				handle.Release();
+		}
+		return handle;
+	}
+
+
+
+	BufferHandle BufferCache::LoadAsync(const String& path, AsyncLoader& loader) {
+		Bool              created;
+		BufferCacheEntry* entry = Acquire(NormalizePath(path), &created);
+		BufferHandle      handle(entry);
+
+		if (created || entry->state == LOADSTATE_FAILED) {
+			entry->state  = LOADSTATE_DECODING;
+			entry->loader = &loader;
+			entry->load   = loader.LoadAsync(path, &entry->buffer,
+				&BufferCache::OnLoaded, entry);
+		}
+		return handle;
+	}
+
+
+
+	Void BufferCache::OnLoaded(SoundBuffer*, const String&, Bool loaded, Lpvoid user) {
+		BufferCacheEntry* entry = (BufferCacheEntry*)(user);
+		entry->state  = loaded ? LOADSTATE_LOADED : LOADSTATE_FAILED;
+		entry->loader = NULL;
+		entry->load   = 0;
+	}
+
+
+
+	BufferHandle BufferCache::Find(const String& path) const {
+		ENTRYMAP::const_iterator found = m_entries.find(NormalizePath(path));
+		return BufferHandle(found != m_entries.end() ? found->second : NULL);
+	}
+
+
+
+	SizeT BufferCache::GetCount() const {
+		return m_entries.size();
+	}
+
+
+
+	String BufferCache::NormalizePath(const String& path) {
+		std::vector<String> parts;
+		String              part;
+		const Bool          absolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+
+		for (SizeT i = 0; i <= path.length(); ++i) {
+			if (i < path.length() && path[i] != '/' && path[i] != '\\') {
+				part += path[i];
+				continue;
+			}
+			if (part == "..") {
+				if (!parts.empty() && parts.back() != "..")
+					parts.pop_back();
+				else if (!absolute)
+					parts.push_back(part);
+			}
+			else if (!part.empty() && part != ".") {
+				parts.push_back(part);
+			}
+			part.clear();
+		}
+		String normalized = absolute ? String(1, '/') : String();
+		for (SizeT i = 0; i < parts.size(); ++i) {
+			if (i > 0)
+				normalized += '/';
+			normalized += parts[i];
+		}
+	#if defined(_WIN32) && !(KZIOBUF_USING_PHYSFS)
+		//only the native file system ignores case, not a custom opener
+		if (!IObuf::GetFileOpener()) {
+			for (auto& c : normalized) {
+				if (c >= 'A' && c <= 'Z')
+					c += 'a' - 'A';
+			}
+		}
+	#endif
+		return normalized;
+	}
+};
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/
@@ -0,0 +1,160 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzbuffercache.h												          |
+| Desc: shared sound buffers keyed by path                                    |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#ifndef __KZBUFFERCACHE_H__
+#define __KZBUFFERCACHE_H__
+
+#include <unordered_map>
+#include "kzasyncloader.h"
+#include "kzaudiointernal.h"
+namespace kz {
+
+
+
+	class BufferCache;
+	struct BufferCacheEntry;
+
+
+
+	/**
+	counted reference to a sound buffer shared through a BufferCache.
+	the buffer is unloaded as soon as its last handle is released.*/
+	class BufferHandle final {
+	public:
+		BufferHandle();
+		BufferHandle(const BufferHandle& copy);
+		BufferHandle& operator=(const BufferHandle& copy);
+		~BufferHandle();
+
+
+		/** drop the reference, the handle becomes invalid*/
+		Void Release();
+
+
+		/** returns true if the handle refers to a buffer*/
+		Bool IsValid() const;
+
+
+		/** returns true if the buffer finished loading successfully*/
+		Bool IsLoaded() const;
+
+
+		/** returns the progress of the buffer's load, LOADSTATE_NONE
+			if the handle is invalid*/
+		LOADSTATE GetState() const;
+
+
+		/** returns the shared buffer, or null if the handle is invalid*/
+		SoundBuffer* Get() const;
+
+
+		/** returns the normalized path the buffer is cached under*/
+		const String& GetPath() const;
+
+
+	private:
+		friend class BufferCache;
+		explicit BufferHandle(BufferCacheEntry* entry);
+
+		BufferCacheEntry* m_entry;
+	};
+
+
+
+	/**
+	loads each sound file once and shares its buffer between every caller
+	asking for the same path. paths are normalized first, so different
+	spellings of a path share a buffer. not thread safe, use it from the
+	thread that owns the audio device.*/
+	class BufferCache final : NonCopyable {
+	public:
+		BufferCache();
+
+		/** handles still held keep their buffers, but are no longer
+			shared with later loads*/
+		~BufferCache();
+
+
+		/**	get the buffer of a file, loading it on first use. a path still
+			being loaded by LoadAsync returns that load's handle.
+			@param path: path/name of the file to load
+			@return:     handle to the buffer, invalid if it failed to load*/
+		BufferHandle Load(const String& path);
+
+
+		/**	get the buffer of a file held in memory, such as an archive
+			entry, loading it on first use
+			@param path:   name the buffer is cached under
+			@param data:   encoded file contents, only read by this call
+			@param nbytes: size of the contents in bytes
+			@return:       handle to the buffer, invalid if it failed to load*/
+		BufferHandle Load(const String& path, Lpcvoid data, SizeT nbytes);
+
+
+		/**	get the buffer of a file held in memory that outlives the
+			buffer, such as an AudioPack entry, loading it on first use
+			with SoundBuffer::LoadMapped
+			@param path:   name the buffer is cached under
+			@param data:   encoded file contents, read again on reloads
+			@param nbytes: size of the contents in bytes
+			@return:       handle to the buffer, invalid if it failed to load*/
+		BufferHandle LoadMapped(const String& path, Lpcvoid data, SizeT nbytes);
+
+
+		/**	get the buffer of a file, queuing its load on a loader on first
+			use. loads already queued for the path are shared.
+			@param path:   path/name of the file to load
+			@param loader: loader decoding the file, it must outlive the load
+			@return:       handle to poll with GetState*/
+		BufferHandle LoadAsync(const String& path, AsyncLoader& loader);
+
+
+		/** returns the handle of a cached path without loading it,
+			invalid if it is not cached*/
+		BufferHandle Find(const String& path) const;
+
+
+		/** returns the number of cached buffers*/
+		SizeT GetCount() const;
+
+
+		/** returns a path with '\\' turned into '/' and empty, "." and ".."
+			components resolved. on windows the path is also lowercased,
+			unless PhysFS or a file opener set with SetFileOpener is used.
+			the key is only used for lookups, files load from the path
+			given by the caller.*/
+		static String NormalizePath(const String& path);
+
+
+	private:
+		friend class BufferHandle;
+		typedef std::unordered_map<String, BufferCacheEntry*> ENTRYMAP;
+
+		BufferCacheEntry* Acquire(const String& key, Bool* created);
+		Void Remove(BufferCacheEntry* entry);
+		static Void OnLoaded(SoundBuffer* buffer, const String& path,
+			Bool loaded, Lpvoid user);
+
+		ENTRYMAP m_entries;
+	};
+};
+/*****************************************************************************/
+#endif//EOF                                                                   |
+/*****************************************************************************/
@@ -0,0 +1,116 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzheaderreader.cpp											          |
+| Desc: buffered little-endian reads of file headers                          |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#include "kzheaderreader.h"
+namespace kz {
+
+
+
+	HeaderReader::HeaderReader(IObuf* iobuf, SizeT window) {
+		m_iobuf       = iobuf;
+		m_window      = NULL;
+		m_windowStart = 0;
+		m_windowSize  = 0;
+		m_position    = iobuf->Tell();
+		m_fetchSize   = window;
+	}
+
+
+
+	Bool HeaderReader::Fetch(Int64 nbytes) {
+		if (m_iobuf->Seek(m_position) == -1) {
+			return false;
+		}
+		m_windowStart = m_position;
+
+		Int64 available = 0;
+		const Byte* view = m_iobuf->GetView(&available);
+		if (view) {
+			//the whole rest of the file is already in memory
+			m_window     = view;
+			m_windowSize = available;
+			return true;
+		}
+		m_storage.resize((SizeT)(Max<Int64>((Int64)(m_fetchSize), nbytes)));
+		m_window     = m_storage.data();
+		m_windowSize = Max<Int64>(m_iobuf->Read(m_storage.data(),
+			(Int64)(m_storage.size())), 0);
+		return true;
+	}
+
+
+
+	Int64 HeaderReader::Read(Lpvoid data, Int64 nbytes) {
+		if (nbytes <= 0) {
+			return 0;
+		}
+		if (m_position < m_windowStart ||
+			m_position + nbytes > m_windowStart + m_windowSize) {
+			if (!Fetch(nbytes))
+				return 0;
+		}
+		Int64 count = Min(nbytes, m_windowStart + m_windowSize - m_position);
+		memcpy(data, m_window + (m_position - m_windowStart), (SizeT)(count));
+		m_position += count;
+		return count;
+	}
+
+
+
+	Bool HeaderReader::ReadU16(Uint16* value) {
+		Byte bytes[2];
+		if (Read(bytes, sizeof(bytes)) != sizeof(bytes))
+			return false;
+		*value = (Uint16)(bytes[0] | (bytes[1] << 0x8));
+		return true;
+	}
+
+
+
+	Bool HeaderReader::ReadU32(Uint32* value) {
+		Byte bytes[4];
+		if (Read(bytes, sizeof(bytes)) != sizeof(bytes))
+			return false;
+		*value = (Uint32)(bytes[0] |
+			(bytes[1] << 0x8) |
+			(bytes[2] << 0x10) |
+			((Uint32)(bytes[3]) << 0x18));
+		return true;
+	}
+
+
+
+	Int64 HeaderReader::Seek(Int64 position) {
+		if (position < 0) {
+			return -1;
+		}
+		m_position = position;
+		return m_position;
+	}
+
+
+
+	Int64 HeaderReader::Tell() const {
+		return m_position;
+	}
+};
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/
@@ -0,0 +1,85 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzheaderreader.h												          |
+| Desc: buffered little-endian reads of file headers                          |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#ifndef __KZHEADERREADER_H__
+#define __KZHEADERREADER_H__
+
+#include <vector>
+#include "kziobuf.h"
+#include "kznoncopyable.h"
+namespace kz {
+
+#define KZHEADERREADER_WINDOW 0x1000
+
+
+
+	/**
+	reads the header of a file through a window fetched with a single
+	read, so decoders can parse many small fields without an i/o call
+	each. fields past the window, after a large chunk is skipped for
+	example, fetch a new window at that offset. memory-backed streams
+	are read in place.*/
+	class HeaderReader final : NonCopyable {
+	public:
+
+		/**	read the header of the given stream
+			@param iobuf:  the stream, read from its current position
+			@param window: bytes to fetch with each read*/
+		explicit HeaderReader(IObuf* iobuf, SizeT window = KZHEADERREADER_WINDOW);
+
+
+		/**	read header bytes
+			@return: number of bytes read, less than nbytes at the end*/
+		Int64 Read(Lpvoid data, Int64 nbytes);
+
+
+		/** read a little-endian unsigned 16-bit value*/
+		Bool ReadU16(Uint16* value);
+
+
+		/** read a little-endian unsigned 32-bit value*/
+		Bool ReadU32(Uint32* value);
+
+
+		/**	move to an absolute offset in the file. no i/o is done until
+			the next read, and none at all if it stays in the window.
+			@return: the new offset, or -1 if it is invalid*/
+		Int64 Seek(Int64 position);
+
+
+		/** returns the current offset in the file*/
+		Int64 Tell() const;
+
+
+	private:
+		Bool Fetch(Int64 nbytes);
+
+		IObuf*            m_iobuf;
+		BYTEDATA          m_storage;
+		const Byte*       m_window;
+		Int64             m_windowStart;
+		Int64             m_windowSize;
+		Int64             m_position;
+		SizeT             m_fetchSize;
+	};
+};
+/*****************************************************************************/
+#endif//EOF                                                                   |
+/*****************************************************************************/
@@ -23,124 +23,285 @@ namespace kz {
 
 
 
+	IOOPENPROC IObuf::s_opener = NULL;
+
+
+
 	IObuf::IObuf() :
-		m_file(nullptr) {
+		m_stream(nullptr),
+		m_owned(false),
+		m_data(nullptr),
+		m_size(-1),
+		m_position(0),
+		m_block(nullptr),
+		m_blockSize(KZIOBUF_BLOCKSIZE),
+		m_blockStart(0),
+		m_blockLength(0),
+		m_streamPosition(0) {
 	}
 
 	IObuf::~IObuf() {
 		Close();
+		if (m_block) {
+			FreeMemory(m_block, (SizeT)(m_blockSize));
+			m_block = nullptr;
+		}
 	}
 
 
 
-#if (KZIOBUF_USING_PHYSFS)
-
 	Bool IObuf::Close() {
-		return m_file ? PHYSFS_close(m_file) : false;
+		if (!m_stream) {
+			return false;
+		}
+		if (m_owned) {
+			delete m_stream;
+		}
+		m_stream         = nullptr;
+		m_owned          = false;
+		m_data           = nullptr;
+		m_size           = -1;
+		m_position       = 0;
+		m_blockStart     = 0;
+		m_blockLength    = 0;
+		m_streamPosition = 0;
+		return true;
 	}
 
 
 	Bool IObuf::Open(const String& filename) {
+		return Open(CreateStream(filename), true);
+	}
+
+
+	Bool IObuf::Open(IOStream* stream, Bool owned) {
 		Close();
-		m_file = PHYSFS_openRead(filename.c_str());
-		return m_file != nullptr;
+		if (!stream) {
+			return false;
+		}
+		m_stream         = stream;
+		m_owned          = owned;
+		m_data           = stream->GetData();
+		m_streamPosition = stream->Tell();
+		m_position       = m_streamPosition;
+		if (m_data) {
+			//memory backed, reads never need to reach the backend
+			m_size = stream->GetSize();
+		}
+		return true;
+	}
+
+
+	Bool IObuf::OpenMapped(const String& filename) {
+	#if !(KZIOBUF_USING_PHYSFS)
+		if (!s_opener) {
+			IOStream* stream = OpenMappedStream(filename);
+			if (stream)
+				return Open(stream, true);
+		}
+	#endif
+		return Open(filename);
 	}
 
 
-	Int64 IObuf::Read(Void* buffer, Int64 nbytes) {
-		if (m_file)
-			return PHYSFS_readBytes(m_file, buffer, nbytes);
-		return -1;
+	Bool IObuf::OpenMemory(Lpcvoid data, Int64 nbytes) {
+		if (!data || nbytes < 0) {
+			Close();
+			return false;
+		}
+		return Open(new MemoryStream(data, nbytes), true);
+	}
+
+
+	Int64 IObuf::Read(Lpvoid buffer, Int64 nbytes) {
+		if (m_data) {
+			Int64 count = Min(nbytes, m_size - m_position);
+			if (count <= 0)
+				return 0;
+			memcpy(buffer, m_data + m_position, (SizeT)(count));
+			m_position += count;
+			return count;
+		}
+		if (!m_stream) {
+			return -1;
+		}
+		Byte* dest  = (Byte*)(buffer);
+		Int64 total = 0;
+
+		while (total < nbytes) {
+			Int64 offset = m_position - m_blockStart;
+			if (offset >= 0 && offset < m_blockLength) {
+				//serve what we can from the cached block
+				Int64 count = Min(nbytes - total, m_blockLength - offset);
+				memcpy(dest + total, m_block + offset, (SizeT)(count));
+				m_position += count;
+				total      += count;
+			}
+			else if (nbytes - total >= m_blockSize) {
+				//large reads go straight to the caller's buffer
+				if (!SyncStream())
+					break;
+				Int64 wanted = nbytes - total;
+				Int64 count  = m_stream->Read(dest + total, wanted);
+				if (count <= 0)
+					break;
+				m_streamPosition += count;
+				m_position       += count;
+				total            += count;
+				if (count < wanted)
+					break;
+			}
+			else if (!FillBlock()) {
+				break;
+			}
+		}
+		return total;
 	}
 
 
 	Int64 IObuf::Seek(Int64 position, Int64 whence) {
-		if (m_file) {
-			if (PHYSFS_seek(m_file, position))
-				return Tell();
+		if (!m_stream) {
+			return -1;
+		}
+		switch (whence) {
+		case SEEK_CUR:
+			position += m_position;
+			break;
+		case SEEK_END:
+			position += GetSize();
+			break;
 		}
-		return -1;
+		if (position < 0) {
+			return -1;
+		}
+		if (m_data && position > m_size) {
+			return -1;
+		}
+		//the backend is only moved when the next block is read
+		m_position = position;
+		return m_position;
 	}
 
 
 	Int64 IObuf::Tell() {
-		return m_file ? PHYSFS_tell(m_file) : -1;
+		return m_stream ? m_position : -1;
 	}
 
 
 	Int64 IObuf::GetSize() {
-		return m_file ? PHYSFS_fileLength(m_file) : -1;
+		if (m_stream && m_size < 0) {
+			m_size = m_stream->GetSize();
+		}
+		return m_stream ? m_size : -1;
 	}
 
 
 	Int32 IObuf::GetEndOfFile() {
-		return m_file ? PHYSFS_eof(m_file) : 0;
+		if (!m_stream) {
+			return 0;
+		}
+		return Tell() >= GetSize();
 	}
 
 
 	Bool IObuf::UsingPhysfs() const {
-		return true;
-	} 
+		return m_stream && m_stream->GetType() == IOSTREAM_PHYSFS;
+	}
+
 
+	IOStream* IObuf::GetStream() const {
+		return m_stream;
+	}
 
-#else  
 
-	Bool IObuf::Close() {
-		return m_file ? !fclose(m_file) : false;
+	IOStream* IObuf::CreateStream(const String& filename) {
+		if (s_opener) {
+			return s_opener(filename);
+		}
+	#if (KZIOBUF_USING_PHYSFS)
+		return OpenPhysfsStream(filename);
+	#else
+		return OpenStdioStream(filename);
+	#endif
 	}
 
 
-	Bool IObuf::Open(const String& filename) {
-		Close();
-		m_file = fopen(filename.c_str(), "rb");
-		return m_file != nullptr;
+	Void IObuf::SetFileOpener(IOOPENPROC opener) {
+		s_opener = opener;
 	}
 
 
-	Int64 IObuf::Read(Lpvoid buffer, Int64 nbytes) {
-		if (m_file)
-			return (Int64)(fread(buffer, 1, (SizeT)(nbytes), m_file));
-		return -1;
+	IOOPENPROC IObuf::GetFileOpener() {
+		return s_opener;
 	}
 
 
-	Int64 IObuf::Seek(Int64 position, Int64 whence) {
-		if (m_file) {
-			if (fseek(m_file, (Long)(position), whence) == 0)
-				return Tell();
+
+	const Byte* IObuf::GetView(Int64* nbytes) const {
+		if (!m_data) {
+			*nbytes = 0;
+			return nullptr;
 		}
-		return -1;
+		*nbytes = m_size - m_position;
+		return m_data + m_position;
 	}
 
 
-	Int64 IObuf::Tell() {
-		return m_file ? ftell(m_file) : -1;
+	Bool IObuf::IsMapped() const {
+		return m_data != nullptr;
 	}
 
 
-	Int64 IObuf::GetSize() {
-		Int64 size, position;
-		if (m_file) {
-			position = Tell();
-			fseek(m_file, 0, SEEK_END);
-			size = Tell();
-			if (Seek(position) != -1)
-				return size;
-		}
-		return -1;
+
+	const Byte* IObuf::GetData(Int64* nbytes) const {
+		*nbytes = m_data ? m_size : 0;
+		return m_data;
 	}
 
 
-	Int32 IObuf::GetEndOfFile() {
-		return m_file ? feof(m_file) : 0;
+
+	Void IObuf::SetBlockSize(SizeT nbytes) {
+		if (m_block) {
+			FreeMemory(m_block, (SizeT)(m_blockSize));
+			m_block = nullptr;
+		}
+		m_blockSize   = (Int64)(nbytes);
+		m_blockStart  = 0;
+		m_blockLength = 0;
 	}
 
 
-	Bool IObuf::UsingPhysfs() const {
-		return false;
+
+	Bool IObuf::SyncStream() {
+		if (m_streamPosition != m_position) {
+			if (m_stream->Seek(m_position) == -1)
+				return false;
+			m_streamPosition = m_position;
+		}
+		return true;
 	}
 
-#endif
+
+
+	Bool IObuf::FillBlock() {
+		if (!m_block) {
+			m_block = (Byte*)(AllocateMemory((SizeT)(m_blockSize)));
+			if (!m_block)
+				return false;
+		}
+		m_blockLength = 0;
+		if (!SyncStream()) {
+			return false;
+		}
+		Int64 count = m_stream->Read(m_block, m_blockSize);
+		if (count <= 0) {
+			return false;
+		}
+		m_blockStart      = m_position;
+		m_blockLength     = count;
+		m_streamPosition += count;
+		return true;
+	}
 };
 /*****************************************************************************/  
 //EOF                                                                         |
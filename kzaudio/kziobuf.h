@@ -20,35 +20,45 @@
 ******************************************************************************/
 #ifndef __KZIOBUF_H__
 #define __KZIOBUF_H__
-/**
-if this define is set to 1, kz::IObuf will use a PHYSFS_File struct,
-otherwise a standard c library FILE struct will be used*/
-#define KZIOBUF_USING_PHYSFS 0
 
-#if (KZIOBUF_USING_PHYSFS)
-#  include <physfs.h>
+#include "kziostream.h"
+/**
+default size in bytes of the read-ahead block that IObuf keeps for
+streamed (non memory backed) sources*/
+#ifndef KZIOBUF_BLOCKSIZE
+#  define KZIOBUF_BLOCKSIZE 0x8000
 #endif
-#include "kzbasetypes.h" 
-#include "kznoncopyable.h" 
-
 namespace kz {
 
 
 
 	/**
-	provides an interface and wrapper around a lower level file structure*/
-	class IObuf final : NonCopyable {
+	provides an interface and wrapper around a lower level file structure.
+	the structure is an IOStream backend chosen at runtime. streamed
+	backends are read in whole blocks that small reads are served from,
+	and the position and size are tracked here so Tell and GetSize
+	never reach the backend after the first call*/
+	class IObuf final : NonCopyable, public Allocated {
 	public:
 		IObuf();
 		~IObuf();
 
 
-		/**	open the file stream from a file path
+		/**	open the file stream from a file path. the stream is created
+			by the function given to SetFileOpener, by default PHYSFS
+			when compiled in, otherwise stdio.
 			@param path: path/name of the file to open
 			@return:     true on success, false on error*/
 		Bool Open(const String& path);
 
 
+		/**	open the file stream over any backend
+			@param stream: byte source to read from
+			@param owned:  if true the stream is deleted on close
+			@return:       true on success, false on error*/
+		Bool Open(IOStream* stream, Bool owned);
+
+
 		/** closes the file stream
 			@return: true on success, false on error*/
 		Bool Close();
@@ -88,12 +98,90 @@ namespace kz {
 		Bool UsingPhysfs() const;
 
 
+		/** returns the backend the stream reads from, or NULL if closed*/
+		IOStream* GetStream() const;
+
+
+		/** create a stream for a path the same way Open does
+			@return: the new stream, or NULL on error
+			         [CALLER OWNS THE RETURNED STREAM]*/
+		static IOStream* CreateStream(const String& path);
+
+
+		/** set the function used by Open to create streams for paths.
+			pass NULL to restore the default. not thread safe, set it
+			once before loading any audio.*/
+		static Void SetFileOpener(IOOPENPROC opener);
+
+
+		/** returns the function set with SetFileOpener, or NULL when
+			the default is in use*/
+		static IOOPENPROC GetFileOpener();
+
+
+		/**	open the file stream as a read-only memory mapping. the file
+			is mapped whole and no file handle is kept open. falls back
+			to Open() when mapping is unavailable (non-posix platforms,
+			a custom file opener or PHYSFS default, empty files or a
+			failed mmap).
+			@param path: path/name of the file to open
+			@return:     true on success, false on error*/
+		Bool OpenMapped(const String& path);
+
+
+		/**	open the stream over a caller-owned block of memory. nothing
+			is copied, the block must stay valid until the stream is
+			closed or reopened.
+			@param data:   start of the memory block
+			@param nbytes: size of the memory block in bytes
+			@return:       true on success, false on error*/
+		Bool OpenMemory(Lpcvoid data, Int64 nbytes);
+
+
+		/**	borrow the unread bytes of a mapped stream without copying.
+			the view is valid until the stream is closed or reopened.
+			consume it by seeking forward past the bytes used.
+			@param nbytes: receives the number of bytes in the view
+			@return:       pointer to the current read position, or
+			               NULL if the stream is not memory backed*/
+		const Byte* GetView(Int64* nbytes) const;
+
+
+		/** returns true if the stream reads from memory, either a
+			mapping or a caller-owned block*/
+		Bool IsMapped() const;
+
+
+		/**	borrow the whole contents of a mapped stream, regardless of
+			the read position. valid until the stream is closed or reopened.
+			@param nbytes: receives the size of the stream in bytes
+			@return:       start of the contents, or NULL if the stream
+			               is not memory backed*/
+		const Byte* GetData(Int64* nbytes) const;
+
+
+		/**	set the size of the read-ahead block used for streamed
+			backends. reads of at least this size bypass the block.
+			@param nbytes: block size in bytes, zero disables caching*/
+		Void SetBlockSize(SizeT nbytes);
+
+
 	private:
-	#if (KZIOBUF_USING_PHYSFS)
-		PHYSFS_File* m_file;
-	#else
-		FILE* m_file;
-	#endif
+		Bool FillBlock();
+		Bool SyncStream();
+
+		IOStream*   m_stream;         //backend, or NULL when closed
+		Bool        m_owned;          //backend is deleted on close
+		const Byte* m_data;           //contents of memory backed streams, or NULL
+		Int64       m_size;           //cached stream size, -1 until known
+		Int64       m_position;       //logical read position
+		Byte*       m_block;          //read-ahead block for streamed backends
+		Int64       m_blockSize;      //capacity of m_block in bytes
+		Int64       m_blockStart;     //stream offset of the cached bytes
+		Int64       m_blockLength;    //number of valid bytes in m_block
+		Int64       m_streamPosition; //position of the backend itself
+
+		static IOOPENPROC s_opener;
 	};
 };
 /*****************************************************************************/  
@@ -0,0 +1,353 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kziostream.cpp												          |
+| Desc: byte source backends that an IObuf can read from                      |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#include "kziostream.h"
+#if defined(__linux__) || defined(__APPLE__)
+#  define KZIOSTREAM_USING_MMAP 1
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#else
+#  define KZIOSTREAM_USING_MMAP 0
+#endif
+namespace kz {
+
+
+
+	StdioStream::StdioStream() :
+		m_file(nullptr) {
+	}
+
+	StdioStream::~StdioStream() {
+		if (m_file) {
+			fclose(m_file);
+		}
+	}
+
+
+	Bool StdioStream::Open(const String& path) {
+		if (m_file) {
+			fclose(m_file);
+		}
+		m_file = fopen(path.c_str(), "rb");
+		return m_file != nullptr;
+	}
+
+
+	Int64 StdioStream::Read(Lpvoid buffer, Int64 nbytes) {
+		if (m_file)
+			return (Int64)(fread(buffer, 1, (SizeT)(nbytes), m_file));
+		return -1;
+	}
+
+
+	Int64 StdioStream::Seek(Int64 position) {
+		if (m_file) {
+			if (fseek(m_file, (Long)(position), SEEK_SET) == 0)
+				return Tell();
+		}
+		return -1;
+	}
+
+
+	Int64 StdioStream::Tell() {
+		return m_file ? ftell(m_file) : -1;
+	}
+
+
+	Int64 StdioStream::GetSize() {
+		Int64 size, position;
+		if (m_file) {
+			position = Tell();
+			fseek(m_file, 0, SEEK_END);
+			size = Tell();
+			if (Seek(position) != -1)
+				return size;
+		}
+		return -1;
+	}
+
+
+	IOSTREAMTYPE StdioStream::GetType() const {
+		return IOSTREAM_STDIO;
+	}
+	/**************************************************************************
+	**************************************************************************/
+
+
+
+
+
+#if (KZIOBUF_USING_PHYSFS)
+	/**************************************************************************
+	**************************************************************************/
+	PhysfsStream::PhysfsStream() :
+		m_file(nullptr) {
+	}
+
+	PhysfsStream::~PhysfsStream() {
+		if (m_file) {
+			PHYSFS_close(m_file);
+		}
+	}
+
+
+	Bool PhysfsStream::Open(const String& path) {
+		if (m_file) {
+			PHYSFS_close(m_file);
+		}
+		m_file = PHYSFS_openRead(path.c_str());
+		return m_file != nullptr;
+	}
+
+
+	Int64 PhysfsStream::Read(Lpvoid buffer, Int64 nbytes) {
+		if (m_file)
+			return PHYSFS_readBytes(m_file, buffer, nbytes);
+		return -1;
+	}
+
+
+	Int64 PhysfsStream::Seek(Int64 position) {
+		if (m_file) {
+			if (PHYSFS_seek(m_file, position))
+				return Tell();
+		}
+		return -1;
+	}
+
+
+	Int64 PhysfsStream::Tell() {
+		return m_file ? PHYSFS_tell(m_file) : -1;
+	}
+
+
+	Int64 PhysfsStream::GetSize() {
+		return m_file ? PHYSFS_fileLength(m_file) : -1;
+	}
+
+
+	IOSTREAMTYPE PhysfsStream::GetType() const {
+		return IOSTREAM_PHYSFS;
+	}
+	/**************************************************************************
+	**************************************************************************/
+#endif
+
+
+
+
+
+	/**************************************************************************
+	**************************************************************************/
+	MemoryStream::MemoryStream(Lpcvoid data, Int64 nbytes) :
+		m_data((const Byte*)(data)),
+		m_size(nbytes),
+		m_position(0) {
+	}
+
+
+	Int64 MemoryStream::Read(Lpvoid buffer, Int64 nbytes) {
+		Int64 count = Min(nbytes, m_size - m_position);
+		if (count <= 0) {
+			return 0;
+		}
+		memcpy(buffer, m_data + m_position, (SizeT)(count));
+		m_position += count;
+		return count;
+	}
+
+
+	Int64 MemoryStream::Seek(Int64 position) {
+		if (position < 0 || position > m_size) {
+			return -1;
+		}
+		m_position = position;
+		return m_position;
+	}
+
+
+	Int64 MemoryStream::Tell() {
+		return m_position;
+	}
+
+
+	Int64 MemoryStream::GetSize() {
+		return m_size;
+	}
+
+
+	const Byte* MemoryStream::GetData() const {
+		return m_data;
+	}
+
+
+	IOSTREAMTYPE MemoryStream::GetType() const {
+		return IOSTREAM_MEMORY;
+	}
+	/**************************************************************************
+	**************************************************************************/
+
+
+
+
+
+	/**************************************************************************
+	**************************************************************************/
+	MappedStream::MappedStream() :
+		MemoryStream(nullptr, 0) {
+	}
+
+	MappedStream::~MappedStream() {
+	#if (KZIOSTREAM_USING_MMAP)
+		if (m_data) {
+			munmap((Lpvoid)(m_data), (SizeT)(m_size));
+		}
+	#endif
+	}
+
+
+	Bool MappedStream::Open(const String& path) {
+	#if (KZIOSTREAM_USING_MMAP)
+		if (m_data) {
+			munmap((Lpvoid)(m_data), (SizeT)(m_size));
+			m_data = nullptr;
+			m_size = 0;
+		}
+		m_position = 0;
+
+		Int32 fd = open(path.c_str(), O_RDONLY);
+		if (fd == -1) {
+			return false;
+		}
+		struct stat info;
+		Lpvoid data = MAP_FAILED;
+		if (fstat(fd, &info) == 0 && info.st_size > 0) {
+			data = mmap(NULL, (SizeT)(info.st_size),
+				PROT_READ, MAP_PRIVATE, fd, 0);
+		}
+		//the mapping holds its own reference to the file
+		close(fd);
+		if (data == MAP_FAILED) {
+			return false;
+		}
+		madvise(data, (SizeT)(info.st_size), MADV_SEQUENTIAL);
+		m_data = (const Byte*)(data);
+		m_size = (Int64)(info.st_size);
+		return true;
+	#else
+		(Void)(path);
+		return false;
+	#endif
+	}
+
+
+	IOSTREAMTYPE MappedStream::GetType() const {
+		return IOSTREAM_MAPPED;
+	}
+	/**************************************************************************
+	**************************************************************************/
+
+
+
+
+
+	/**************************************************************************
+	**************************************************************************/
+	CallbackStream::CallbackStream(const IOCallbacks& callbacks) :
+		m_callbacks(callbacks) {
+	}
+
+	CallbackStream::~CallbackStream() {
+		if (m_callbacks.close) {
+			m_callbacks.close(m_callbacks.user);
+		}
+	}
+
+
+	Int64 CallbackStream::Read(Lpvoid buffer, Int64 nbytes) {
+		return m_callbacks.read(m_callbacks.user, buffer, nbytes);
+	}
+
+
+	Int64 CallbackStream::Seek(Int64 position) {
+		return m_callbacks.seek(m_callbacks.user, position);
+	}
+
+
+	Int64 CallbackStream::Tell() {
+		return m_callbacks.tell(m_callbacks.user);
+	}
+
+
+	Int64 CallbackStream::GetSize() {
+		return m_callbacks.size(m_callbacks.user);
+	}
+
+
+	IOSTREAMTYPE CallbackStream::GetType() const {
+		return IOSTREAM_USER;
+	}
+	/**************************************************************************
+	**************************************************************************/
+
+
+
+
+
+	/**************************************************************************
+	**************************************************************************/
+	IOStream* OpenStdioStream(const String& path) {
+		StdioStream* stream = new StdioStream();
+		if (!stream->Open(path)) {
+			delete stream;
+			return NULL;
+		}
+		return stream;
+	}
+
+
+
+	IOStream* OpenMappedStream(const String& path) {
+		MappedStream* stream = new MappedStream();
+		if (!stream->Open(path)) {
+			delete stream;
+			return NULL;
+		}
+		return stream;
+	}
+
+
+
+#if (KZIOBUF_USING_PHYSFS)
+	IOStream* OpenPhysfsStream(const String& path) {
+		PhysfsStream* stream = new PhysfsStream();
+		if (!stream->Open(path)) {
+			delete stream;
+			return NULL;
+		}
+		return stream;
+	}
+#endif
+};
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/
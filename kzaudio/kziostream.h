@@ -0,0 +1,226 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kziostream.h												          |
+| Desc: byte source backends that an IObuf can read from                      |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#ifndef __KZIOSTREAM_H__
+#define __KZIOSTREAM_H__
+/**
+if this define is set to 1, the PHYSFS_File backend is compiled in and
+becomes the default for opening files by path. the stdio, mapped, memory
+and user callback backends are always available*/
+#ifndef KZIOBUF_USING_PHYSFS
+#  define KZIOBUF_USING_PHYSFS 0
+#endif
+
+#if (KZIOBUF_USING_PHYSFS)
+#  include <physfs.h>
+#endif
+#include "kzallocator.h"
+#include "kzbasetypes.h"
+#include "kznoncopyable.h"
+
+namespace kz {
+
+
+
+	/**
+	identifies the kind of backend behind an IOStream*/
+	typedef enum {
+		IOSTREAM_STDIO,
+		IOSTREAM_PHYSFS,
+		IOSTREAM_MAPPED,
+		IOSTREAM_MEMORY,
+		IOSTREAM_USER
+	} IOSTREAMTYPE;
+
+
+
+	/**
+	abstract source of bytes read by an IObuf. streams are only called
+	for whole blocks of data, never once per sample, so the cost of the
+	virtual dispatch does not show up in decoding.*/
+	class IOStream : NonCopyable, public Allocated {
+	public:
+		virtual ~IOStream() {}
+
+		/**	read data from the stream
+			@param buffer: buffer to store read data into
+			@param nbytes: number of bytes being read
+			@return:       number of bytes read, or -1 on error*/
+		virtual Int64 Read(Lpvoid buffer, Int64 nbytes) = 0;
+
+		/**	seek to an absolute position in the stream
+			@param position: byte offset from the beginning
+			@return:         the position sought to, or -1 on error*/
+		virtual Int64 Seek(Int64 position) = 0;
+
+		/**	get the current reading position in the stream
+			@return: The current position, or -1 on error*/
+		virtual Int64 Tell() = 0;
+
+		/**	return the size of the stream
+			@return: total bytes available in the stream (-1 on error)*/
+		virtual Int64 GetSize() = 0;
+
+		/**	returns the whole contents of memory backed streams,
+			or NULL when the data has to be read through Read()*/
+		virtual const Byte* GetData() const { return NULL; }
+
+		/** returns the kind of backend*/
+		virtual IOSTREAMTYPE GetType() const = 0;
+	};
+
+
+
+	/**
+	stream over a standard c library FILE struct*/
+	class StdioStream final : public IOStream {
+	public:
+		StdioStream();
+		~StdioStream();
+
+		/** open the file at the given path, returns true on success*/
+		Bool Open(const String& path);
+
+		Int64        Read(Lpvoid buffer, Int64 nbytes) override;
+		Int64        Seek(Int64 position) override;
+		Int64        Tell() override;
+		Int64        GetSize() override;
+		IOSTREAMTYPE GetType() const override;
+
+	private:
+		FILE* m_file;
+	};
+
+
+
+#if (KZIOBUF_USING_PHYSFS)
+	/**
+	stream over a PHYSFS_File struct*/
+	class PhysfsStream final : public IOStream {
+	public:
+		PhysfsStream();
+		~PhysfsStream();
+
+		/** open the file at the given virtual path, returns true on success*/
+		Bool Open(const String& path);
+
+		Int64        Read(Lpvoid buffer, Int64 nbytes) override;
+		Int64        Seek(Int64 position) override;
+		Int64        Tell() override;
+		Int64        GetSize() override;
+		IOSTREAMTYPE GetType() const override;
+
+	private:
+		PHYSFS_File* m_file;
+	};
+#endif
+
+
+
+	/**
+	stream over a caller-owned block of memory. nothing is copied, the
+	block must stay valid for the lifetime of the stream*/
+	class MemoryStream : public IOStream {
+	public:
+		MemoryStream(Lpcvoid data, Int64 nbytes);
+
+		Int64        Read(Lpvoid buffer, Int64 nbytes) override;
+		Int64        Seek(Int64 position) override;
+		Int64        Tell() override;
+		Int64        GetSize() override;
+		const Byte*  GetData() const override;
+		IOSTREAMTYPE GetType() const override;
+
+	protected:
+		const Byte* m_data;
+		Int64       m_size;
+		Int64       m_position;
+	};
+
+
+
+	/**
+	read-only memory mapping of a whole file (posix platforms only).
+	no file handle is kept open once the file is mapped*/
+	class MappedStream final : public MemoryStream {
+	public:
+		MappedStream();
+		~MappedStream();
+
+		/** map the file at the given path, returns true on success.
+			always fails on platforms without mmap and for empty files*/
+		Bool Open(const String& path);
+
+		IOSTREAMTYPE GetType() const override;
+	};
+
+
+
+	/**
+	user supplied functions for reading a custom byte source*/
+	struct IOCallbacks {
+		Int64 (*read)(Lpvoid user, Lpvoid buffer, Int64 nbytes);
+		Int64 (*seek)(Lpvoid user, Int64 position);
+		Int64 (*tell)(Lpvoid user);
+		Int64 (*size)(Lpvoid user);
+		Void  (*close)(Lpvoid user); //optional, called on destruction
+		Lpvoid user;                 //passed back to every callback
+	};
+
+
+
+	/**
+	stream that forwards to user supplied callbacks*/
+	class CallbackStream final : public IOStream {
+	public:
+		explicit CallbackStream(const IOCallbacks& callbacks);
+		~CallbackStream();
+
+		Int64        Read(Lpvoid buffer, Int64 nbytes) override;
+		Int64        Seek(Int64 position) override;
+		Int64        Tell() override;
+		Int64        GetSize() override;
+		IOSTREAMTYPE GetType() const override;
+
+	private:
+		IOCallbacks m_callbacks;
+	};
+
+
+
+
+	/** function used to open a stream for a file path.
+		returns NULL on failure [CALLER OWNS THE RETURNED STREAM]*/
+	typedef IOStream* (*IOOPENPROC)(const String& path);
+
+	/** open a file by path with the stdio backend*/
+	extern IOStream* OpenStdioStream(const String& path);
+
+	/** open a file by path as a memory mapping*/
+	extern IOStream* OpenMappedStream(const String& path);
+
+#if (KZIOBUF_USING_PHYSFS)
+	/** open a file by virtual path with the PHYSFS backend*/
+	extern IOStream* OpenPhysfsStream(const String& path);
+#endif
+};
+/*****************************************************************************/
+#endif//EOF                                                                   |
+/*****************************************************************************/
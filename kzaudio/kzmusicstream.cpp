@@ -21,6 +21,7 @@
 #include <al/al.h> 
 #include "kzaudiodevice.h"
 #include "kzmusicstream.h"
+#include "kzprefetchstream.h"
 namespace kz {
 
 
@@ -29,6 +30,12 @@ namespace kz {
 		m_gain        = 1.f;
 		m_volume      = 1.f;
 		m_loopEnabled = true;
+		m_prefetchSize = KZMUSICSTREAM_PREFETCH;
+		m_prefetch     = NULL;
+		m_floatOutput  = false;
+		m_floatEnabled = false;
+		m_loopStart    = 0;
+		m_loopEnd      = 0;
 		alGenSources(1, &m_alsource);
 		alGenBuffers(STREAMFRAGMENTS, m_buffers);
 	}
@@ -97,21 +104,87 @@ namespace kz {
 
 
 
+	Void MusicStream::SetPrefetchSize(SizeT nbytes) {
+		m_prefetchSize = nbytes;
+	}
+
+	Void MusicStream::SetFloatOutput(Bool enabled) {
+		m_floatOutput = enabled;
+	}
+
+	Bool MusicStream::IsFloatOutput() const {
+		return m_floatEnabled;
+	}
+
+
+
+	Void MusicStream::GetPrefetchStats(Uint64* hits, Uint64* stalls) const {
+		*hits   = m_prefetch ? m_prefetch->GetHitCount() : 0;
+		*stalls = m_prefetch ? m_prefetch->GetStallCount() : 0;
+	}
+
+
+
 	Bool MusicStream::Load(const String& filename) {
-		AudioDesc desc;
-		Int32     i, queued;
+		m_prefetch = NULL;
+		if (m_prefetchSize > 0) {
+			IOStream* source = IObuf::CreateStream(filename);
+			if (!source) {
+				m_file.Close();
+				return false;
+			}
+			//the file owns the prefetcher, we only keep it for the stats
+			PrefetchStream* prefetch = new PrefetchStream(source, m_prefetchSize);
+			if (!m_file.Load(prefetch)) {
+				return false;
+			}
+			m_prefetch = prefetch;
+		}
+		else if (!m_file.Load(filename)) {
+			return false;
+		}
+		return Initialize();
+	}
+
+
 
-		if (!m_file.Load(filename)) {
+	Bool MusicStream::Load(Lpcvoid data, SizeT nbytes) {
+		m_prefetch = NULL;
+		if (!m_file.Load(data, nbytes)) {
 			return false;
 		}
+		return Initialize();
+	}
+
+
+
+	Bool MusicStream::Initialize() {
+		AudioDesc desc;
+		Int32     i, queued;
+
 		m_file.GetDesc(&desc);
 
-		m_format     = AudioDevice::GetFormat(desc.nchannels);
+		m_floatEnabled = false;
+		m_format       = 0;
+		if (m_floatOutput && m_file.SupportsFloat()) {
+			m_format       = AudioDevice::GetFloatFormat(desc.nchannels);
+			m_floatEnabled = m_format != 0;
+		}
+		if (!m_floatEnabled) {
+			m_format = AudioDevice::GetFormat(desc.nchannels);
+		}
+		//without loop points the whole file loops, zero end means no limit
+		Uint64 loopStart = 0, loopEnd = 0;
+		m_file.GetLoopPoints(&loopStart, &loopEnd);
+		m_loopStart = loopStart * desc.nchannels;
+		m_loopEnd   = loopEnd * desc.nchannels;
+
 		m_sampleRate = desc.sampleRate;
 		m_buffersize = m_sampleRate * desc.nchannels;
-		m_bufferdata.resize(m_buffersize);
+		m_bufferdata.resize(m_floatEnabled ? 0 : m_buffersize);
+		m_floatdata.resize(m_floatEnabled ? m_buffersize : 0);
 
-		if (m_bufferdata.empty()) {
+		if (m_buffersize == 0) {
 			return false;
 		}
 		alGetSourcei(m_alsource, AL_BUFFERS_QUEUED, &queued);
@@ -145,25 +218,44 @@ namespace kz {
 
 
 
+	Uint64 MusicStream::ReadSamples(Uint64 offset, Uint64 count) {
+		if (m_floatEnabled)
+			return m_file.ReadFloat(m_floatdata.data() + offset, count);
+		return m_file.Read(m_bufferdata.data() + offset, count);
+	}
+
+
+
 	Bool MusicStream::FillBufferQueue(Uint32 buffer) {
 		Int32  size;
 		Uint64 bytesread = 0;
-		Int16* data = m_bufferdata.data();
+		Lpcvoid data = m_floatEnabled ? (Lpcvoid)(m_floatdata.data()) :
+		                                (Lpcvoid)(m_bufferdata.data());
+		const SizeT sampleSize = m_floatEnabled ? sizeof(Float) : sizeof(Int16);
+		Bool rewound = false;
 
 		do {
-			bytesread += m_file.Read(
-				data + bytesread,
-				m_buffersize - bytesread);
+			Uint64 count = m_buffersize - bytesread;
+			if (m_loopEnabled && m_loopEnd != 0) {
+				//stop at the loop end, the loop start follows in the same buffer
+				AudioDesc desc;
+				m_file.GetDesc(&desc);
+				count = desc.sampleOffset < m_loopEnd ?
+					Min(count, m_loopEnd - desc.sampleOffset) : 0;
+			}
+			Uint64 read = ReadSamples(bytesread, count);
+			bytesread += read;
 
 			if (bytesread < m_buffersize) {
-				if (m_loopEnabled)
-					m_file.Seek(0);
-				else break;
+				if (!m_loopEnabled || (read == 0 && rewound))
+					break;
+				m_file.Seek(m_loopStart);
+				rewound = read == 0;
 			}
 		} while (bytesread < m_buffersize);
 
 		if (bytesread > 0) {
-			size = (Int32)(bytesread * sizeof(Int16));
+			size = (Int32)(bytesread * sampleSize);
 			alBufferData(buffer, m_format, data, size, m_sampleRate);
 			alSourceQueueBuffers(m_alsource, 1, &buffer);
 		}
@@ -22,12 +22,20 @@
 #define __KZMUSICSTREAM_H__ 
 
 #include "kzaudiofile.h"
+/**
+default number of bytes a music stream reads ahead of the decoder on
+its background i/o thread (zero disables prefetching)*/
+#ifndef KZMUSICSTREAM_PREFETCH
+#  define KZMUSICSTREAM_PREFETCH 0x40000
+#endif
 namespace kz {
+
+	class PrefetchStream;
 
 
 	/**
 	interface for managing a music stream*/
-	class MusicStream final : NonCopyable {
+	class MusicStream final : NonCopyable, public Allocated {
 	public:
 
 		/** construct music instance*/
@@ -39,6 +47,12 @@ namespace kz {
 			@return: true if loaded successfully, else false*/
 		Bool Load(const String& filename);
 
+		/** open music from an encoded file held in memory. the data is
+			streamed in place and must remain valid while the music
+			is loaded.
+			@return: true if loaded successfully, else false*/
+		Bool Load(Lpcvoid data, SizeT nbytes);
+
 		/** update the music stream. this function must
 			be called once during the main program loop*/
 		Void Update();
@@ -72,28 +86,62 @@ namespace kz {
 
 
 		/** set whether the stream loops after reaching the end
-			(this is enabled by default)*/
+			(this is enabled by default). files with loop points in
+			their metadata play up to the loop end, then continue
+			from the loop start, exact to the sample.*/
 		Void SetLoopEnabled(Bool loop);
 
 		/** returns true if the stream loops after reaching the end*/
 		Bool IsLoopEnabled() const;
 
 
+		/** set how many bytes of a music file are read ahead on a
+			background thread, so Update only decodes from memory.
+			applies to files loaded by path after this call, zero
+			disables prefetching.*/
+		Void SetPrefetchSize(SizeT nbytes);
+
+		/** set whether the stream is decoded to float32 buffers instead
+			of 16-bit, when the device has AL_EXT_FLOAT32 and the format
+			decodes to float (OGG/Vorbis, Opus). this skips the conversion to
+			16-bit. applies to files loaded after this call, disabled
+			by default.*/
+		Void SetFloatOutput(Bool enabled);
+
+		/** returns true if the current file is streamed as float32*/
+		Bool IsFloatOutput() const;
+
+
+		/** get the prefetch counters of the current file
+			@param hits:   receives reads served from memory
+			@param stalls: receives reads that waited for the disk*/
+		Void GetPrefetchStats(Uint64* hits, Uint64* stalls) const;
+
+
 	private:
 		enum { STREAMFRAGMENTS = 5 };
 
-		Bool FillBufferQueue(Uint32 buffer);
-
-		Uint32     m_alsource;
-		Float      m_gain;
-		Float      m_volume;
-		AudioFile  m_file;
-		Uint32     m_buffers[STREAMFRAGMENTS];
-		Bool       m_loopEnabled;
-		Int32      m_format;
-		Uint32     m_buffersize;
-		SAMPLEDATA m_bufferdata;
-		Uint32     m_sampleRate;
+		Bool   Initialize();
+		Bool   FillBufferQueue(Uint32 buffer);
+		Uint64 ReadSamples(Uint64 offset, Uint64 count);
+
+		Uint32             m_alsource;
+		Float              m_gain;
+		Float              m_volume;
+		AudioFile          m_file;
+		Uint32             m_buffers[STREAMFRAGMENTS];
+		Bool               m_loopEnabled;
+		Int32              m_format;
+		Uint32             m_buffersize;
+		SAMPLEDATA         m_bufferdata;
+		FLOATDATA          m_floatdata;
+		Bool               m_floatOutput;
+		Bool               m_floatEnabled;
+		Uint32             m_sampleRate;
+		SizeT              m_prefetchSize;
+		PrefetchStream*    m_prefetch;
+		Uint64             m_loopStart;
+		Uint64             m_loopEnd;
 	};
 };
 /*****************************************************************************/  
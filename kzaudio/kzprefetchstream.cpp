@@ -0,0 +1,189 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzprefetchstream.cpp										          |
+| Desc: stream that reads ahead of the decoder on a background thread         |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#include "kzprefetchstream.h"
+namespace kz {
+
+
+
+	PrefetchStream::PrefetchStream(IOStream* source, SizeT nbytes) :
+		m_source(source),
+		m_sourceType(source->GetType()),
+		m_size(source->GetSize()),
+		m_ring(Max<SizeT>(nbytes, 1)),
+		m_head(0),
+		m_count(0),
+		m_position(source->Tell()),
+		m_generation(0),
+		m_eof(false),
+		m_quit(false),
+		m_hits(0),
+		m_stalls(0) {
+		m_thread = std::thread(&PrefetchStream::Run, this);
+	}
+
+
+
+	PrefetchStream::~PrefetchStream() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_wakeup.notify_one();
+		m_thread.join();
+		delete m_source;
+	}
+
+
+
+	Int64 PrefetchStream::Read(Lpvoid buffer, Int64 nbytes) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		Byte*      dest     = (Byte*)(buffer);
+		const SizeT capacity = m_ring.size();
+		Int64      total    = 0;
+		Bool       stalled  = false;
+
+		while (total < nbytes) {
+			if (m_count > 0) {
+				Int64 count = Min(nbytes - total, m_count);
+				Int64 first = Min(count, (Int64)(capacity - m_head));
+				memcpy(dest + total, &m_ring[m_head], (SizeT)(first));
+				memcpy(dest + total + first, &m_ring[0], (SizeT)(count - first));
+
+				m_head      = (m_head + (SizeT)(count)) % capacity;
+				m_count    -= count;
+				m_position += count;
+				total      += count;
+				m_wakeup.notify_one();
+			}
+			else if (m_eof) {
+				break;
+			}
+			else {
+				stalled = true;
+				m_ready.wait(lock);
+			}
+		}
+		if (stalled)
+			++m_stalls;
+		else ++m_hits;
+		return total;
+	}
+
+
+
+	Int64 PrefetchStream::Seek(Int64 position) {
+		if (position < 0) {
+			return -1;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Int64 skip = position - m_position;
+
+		if (skip >= 0 && skip <= m_count) {
+			//target is already buffered, just drop the bytes before it
+			m_head      = (m_head + (SizeT)(skip)) % m_ring.size();
+			m_count    -= skip;
+			m_position  = position;
+		}
+		else {
+			m_head      = 0;
+			m_count     = 0;
+			m_position  = position;
+			m_eof       = false;
+			++m_generation;
+		}
+		m_wakeup.notify_one();
+		return m_position;
+	}
+
+
+
+	Int64 PrefetchStream::Tell() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_position;
+	}
+
+
+
+	Int64 PrefetchStream::GetSize() {
+		return m_size;
+	}
+
+
+
+	IOSTREAMTYPE PrefetchStream::GetType() const {
+		return m_sourceType;
+	}
+
+
+
+	Uint64 PrefetchStream::GetHitCount() const {
+		return m_hits;
+	}
+
+
+
+	Uint64 PrefetchStream::GetStallCount() const {
+		return m_stalls;
+	}
+
+
+
+	Void PrefetchStream::Run() {
+		const SizeT capacity  = m_ring.size();
+		const SizeT chunkSize = Max<SizeT>(capacity / 4, 1);
+		Int64       sourcePosition = m_position;
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (!m_quit) {
+			if (m_eof || m_count == (Int64)(capacity)) {
+				m_wakeup.wait(lock);
+				continue;
+			}
+			//only the free part of the ring is written, readers never
+			//look past m_count so the copy can happen unlocked
+			Uint32 generation = m_generation;
+			Int64  position   = m_position + m_count;
+			SizeT  tail       = (m_head + (SizeT)(m_count)) % capacity;
+			SizeT  space      = Min(capacity - (SizeT)(m_count), capacity - tail);
+			SizeT  request    = Min(space, chunkSize);
+			lock.unlock();
+
+			Int64 count = -1;
+			if (sourcePosition == position ||
+				m_source->Seek(position) != -1) {
+				count = m_source->Read(&m_ring[tail], (Int64)(request));
+			}
+			sourcePosition = count > 0 ? position + count : -1;
+
+			lock.lock();
+			if (generation != m_generation) {
+				continue;//a seek dropped the buffer while we were reading
+			}
+			if (count > 0)
+				m_count += count;
+			else m_eof = true;
+			m_ready.notify_all();
+		}
+	}
+};
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/
@@ -0,0 +1,85 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzprefetchstream.h											          |
+| Desc: stream that reads ahead of the decoder on a background thread         |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#ifndef __KZPREFETCHSTREAM_H__
+#define __KZPREFETCHSTREAM_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "kziostream.h"
+namespace kz {
+
+
+
+	/**
+	stream that keeps the next bytes of another stream in memory. a
+	background i/o thread fills a ring buffer ahead of the read position
+	so reads only copy from RAM unless the reader outruns the thread.
+	the source is only ever touched by the i/o thread once constructed.*/
+	class PrefetchStream final : public IOStream {
+	public:
+
+		/**	start prefetching from the given source
+			@param source: stream to read ahead of [TAKES OWNERSHIP]
+			@param nbytes: how many bytes to keep buffered ahead*/
+		PrefetchStream(IOStream* source, SizeT nbytes);
+		~PrefetchStream();
+
+		Int64        Read(Lpvoid buffer, Int64 nbytes) override;
+		Int64        Seek(Int64 position) override;
+		Int64        Tell() override;
+		Int64        GetSize() override;
+		IOSTREAMTYPE GetType() const override;
+
+
+		/** returns how many reads were served without waiting*/
+		Uint64 GetHitCount() const;
+
+		/** returns how many reads had to wait for the i/o thread*/
+		Uint64 GetStallCount() const;
+
+
+	private:
+		Void Run();
+
+		IOStream*               m_source;     //stream being read ahead
+		IOSTREAMTYPE            m_sourceType; //backend kind of m_source
+		Int64                   m_size;       //size of m_source in bytes
+		BYTEDATA                m_ring;       //buffered bytes
+		SizeT                   m_head;       //ring index of the read position
+		Int64                   m_count;      //valid bytes from m_head
+		Int64                   m_position;   //stream offset of m_head
+		Uint32                  m_generation; //bumped when a seek drops the buffer
+		Bool                    m_eof;        //source has no more bytes
+		Bool                    m_quit;       //i/o thread should exit
+		std::atomic<Uint64>     m_hits;
+		std::atomic<Uint64>     m_stalls;
+		std::mutex              m_mutex;
+		std::condition_variable m_wakeup;     //signals the i/o thread
+		std::condition_variable m_ready;      //signals waiting readers
+		std::thread             m_thread;
+	};
+};
+/*****************************************************************************/
+#endif//EOF                                                                   |
+/*****************************************************************************/
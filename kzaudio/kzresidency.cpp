@@ -0,0 +1,212 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzresidency.cpp												          |
+| Desc: sound buffers kept within a memory budget                             |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#include "kzresidency.h"
+#include "kzsoundbuffer.h"
+namespace kz {
+
+
+
+	ResidencyManager::ResidencyManager(Uint64 budget) :
+		m_firstBuffer(NULL),
+		m_lastBuffer(NULL),
+		m_residentBytes(0),
+		m_budget(budget),
+		m_hits(0),
+		m_misses(0),
+		m_evictions(0) {
+	}
+
+
+
+	ResidencyManager::~ResidencyManager() {
+		while (m_firstBuffer) {
+			Forget(m_firstBuffer);
+		}
+	}
+
+
+
+	Void ResidencyManager::SetBudget(Uint64 budget) {
+		m_budget = budget;
+		Trim(NULL);
+	}
+
+
+
+	Uint64 ResidencyManager::GetBudget() const {
+		return m_budget;
+	}
+
+
+
+	Void ResidencyManager::Add(SoundBuffer* buffer) {
+		if (buffer->m_manager == this) {
+			return;
+		}
+		if (buffer->m_manager) {
+			buffer->m_manager->Remove(buffer);
+		}
+		buffer->m_manager = this;
+		buffer->m_managedBytes = 0;
+		Link(buffer);
+		Account(buffer);
+		Trim(buffer);
+	}
+
+
+
+	Void ResidencyManager::Remove(SoundBuffer* buffer) {
+		if (buffer->m_manager == this) {
+			Forget(buffer);
+		}
+	}
+
+
+
+	Void ResidencyManager::Link(SoundBuffer* buffer) {
+		buffer->m_prevManaged = NULL;
+		buffer->m_nextManaged = m_firstBuffer;
+		if (m_firstBuffer)
+			m_firstBuffer->m_prevManaged = buffer;
+		else m_lastBuffer = buffer;
+		m_firstBuffer = buffer;
+	}
+
+
+
+	Void ResidencyManager::Unlink(SoundBuffer* buffer) {
+		if (buffer->m_prevManaged)
+			buffer->m_prevManaged->m_nextManaged = buffer->m_nextManaged;
+		else m_firstBuffer = buffer->m_nextManaged;
+		if (buffer->m_nextManaged)
+			buffer->m_nextManaged->m_prevManaged = buffer->m_prevManaged;
+		else m_lastBuffer = buffer->m_prevManaged;
+		buffer->m_prevManaged = NULL;
+		buffer->m_nextManaged = NULL;
+	}
+
+
+
+	Void ResidencyManager::Forget(SoundBuffer* buffer) {
+		Unlink(buffer);
+		m_residentBytes -= buffer->m_managedBytes;
+		buffer->m_managedBytes = 0;
+		buffer->m_manager = NULL;
+	}
+
+
+
+	Void ResidencyManager::Rebind(SoundBuffer* from, SoundBuffer* to) {
+		//the moved-to buffer takes the place of the other one in the list
+		to->m_manager = this;
+		to->m_prevManaged = from->m_prevManaged;
+		to->m_nextManaged = from->m_nextManaged;
+		if (to->m_prevManaged)
+			to->m_prevManaged->m_nextManaged = to;
+		else m_firstBuffer = to;
+		if (to->m_nextManaged)
+			to->m_nextManaged->m_prevManaged = to;
+		else m_lastBuffer = to;
+		m_residentBytes -= from->m_managedBytes;
+		from->m_managedBytes = 0;
+		from->m_prevManaged = NULL;
+		from->m_nextManaged = NULL;
+		from->m_manager = NULL;
+		to->m_managedBytes = 0;
+		Account(to);
+	}
+
+
+
+	Void ResidencyManager::Account(SoundBuffer* buffer) {
+		Uint64 cpuBytes = 0, deviceBytes = 0;
+		buffer->GetMemoryUsage(&cpuBytes, &deviceBytes);
+		m_residentBytes -= buffer->m_managedBytes;
+		buffer->m_managedBytes = cpuBytes + deviceBytes;
+		m_residentBytes += buffer->m_managedBytes;
+	}
+
+
+
+	Bool ResidencyManager::Touch(const SoundBuffer* buffer) {
+		if (buffer->m_manager != this) {
+			return true;
+		}
+		//buffers are added by their owner through a non-const pointer
+		SoundBuffer* managed = const_cast<SoundBuffer*>(buffer);
+		if (managed != m_firstBuffer) {
+			Unlink(managed);
+			Link(managed);
+		}
+		if (managed->IsEvicted()) {
+			++m_misses;
+			if (!managed->Reload())
+				return false;
+		}
+		else ++m_hits;
+
+		//the touched buffer is about to play, it must stay loaded
+		Trim(buffer);
+		return true;
+	}
+
+
+
+	Void ResidencyManager::Trim() {
+		Trim(NULL);
+	}
+
+
+
+	Void ResidencyManager::Trim(const SoundBuffer* keep) {
+		//least recently played first, buffers of playing or paused
+		//sounds are never evicted
+		SoundBuffer* buffer = m_lastBuffer;
+		while (buffer && m_residentBytes > m_budget) {
+			SoundBuffer* previous = buffer->m_prevManaged;
+			if (buffer != keep && !buffer->IsEvicted() && !buffer->IsInUse() &&
+				buffer->Evict()) {
+				++m_evictions;
+			}
+			buffer = previous;
+		}
+	}
+
+
+
+	Void ResidencyManager::GetStats(ResidencyStats* stats) const {
+		stats->hits          = m_hits;
+		stats->misses        = m_misses;
+		stats->evictions     = m_evictions;
+		stats->residentBytes = m_residentBytes;
+	}
+
+
+
+	Void ResidencyManager::ResetStats() {
+		m_hits      = 0;
+		m_misses    = 0;
+		m_evictions = 0;
+	}
+};
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/
\ No newline at end of file
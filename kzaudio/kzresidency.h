@@ -0,0 +1,125 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzresidency.h												          |
+| Desc: sound buffers kept within a memory budget                             |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#ifndef __KZRESIDENCY_H__
+#define __KZRESIDENCY_H__
+
+#include "kzaudiointernal.h"
+namespace kz {
+
+
+
+	/** default budget of a ResidencyManager, in bytes*/
+	#ifndef KZRESIDENCY_BUDGET
+	#define KZRESIDENCY_BUDGET (64 * 1024 * 1024)
+	#endif
+
+
+
+	/**
+	counters of a ResidencyManager*/
+	struct ResidencyStats {
+		Uint64 hits;          //plays of a resident buffer
+		Uint64 misses;        //plays that had to reload an evicted buffer
+		Uint64 evictions;     //buffers unloaded to stay within the budget
+		Uint64 residentBytes; //cpu and device bytes held by managed buffers
+	};
+
+
+
+	/**
+	keeps the memory held by a set of sound buffers within a budget. when
+	the budget is exceeded, the least recently played buffers that are not
+	attached to a playing or paused sound are unloaded. an unloaded buffer
+	is loaded again from its source when one of its sounds is played.
+
+	only buffers that can be loaded again are evicted, ie buffers loaded
+	from a file, with LoadMapped, or loaded from memory with
+	SAMPLERESIDENCY_DEVICE. not thread safe, use it from the thread that
+	owns the audio device.*/
+	class ResidencyManager final : NonCopyable {
+	public:
+		explicit ResidencyManager(Uint64 budget = KZRESIDENCY_BUDGET);
+
+		/** buffers still managed are removed. evicted ones stay evicted
+			until one of their sounds is played, see Remove*/
+		~ResidencyManager();
+
+
+		/** set the number of cpu and device bytes buffers may hold,
+			evicting buffers if they now exceed it*/
+		Void SetBudget(Uint64 budget);
+
+
+		/** returns the number of bytes buffers may hold*/
+		Uint64 GetBudget() const;
+
+
+		/** manage a buffer, it is removed when destroyed. a buffer is
+			managed by one manager at a time.*/
+		Void Add(SoundBuffer* buffer);
+
+
+		/** stop managing a buffer. an evicted buffer is not decoded here,
+			it is loaded again when one of its sounds is played*/
+		Void Remove(SoundBuffer* buffer);
+
+
+		/** mark a buffer as used, loading it again if it was evicted.
+			called by Sound::Play.
+			@return: false if the buffer is evicted and failed to load*/
+		Bool Touch(const SoundBuffer* buffer);
+
+
+		/** evict buffers until the budget is met, or no buffer can be
+			evicted*/
+		Void Trim();
+
+
+		/** get the counters of the manager*/
+		Void GetStats(ResidencyStats* stats) const;
+
+
+		/** reset the hit, miss and eviction counters*/
+		Void ResetStats();
+
+
+	private:
+		friend class SoundBuffer;
+
+		Void Trim(const SoundBuffer* keep);
+		Void Link(SoundBuffer* buffer);
+		Void Unlink(SoundBuffer* buffer);
+		Void Forget(SoundBuffer* buffer);
+		Void Rebind(SoundBuffer* from, SoundBuffer* to);
+		Void Account(SoundBuffer* buffer);
+
+		SoundBuffer* m_firstBuffer;   //managed buffers, most recently played
+		SoundBuffer* m_lastBuffer;    //first. linked in place, so neither a
+		Uint64       m_residentBytes; //play nor a move allocates
+		Uint64       m_budget;
+		Uint64       m_hits;
+		Uint64       m_misses;
+		Uint64       m_evictions;
+	};
+};
+/*****************************************************************************/
+#endif//EOF                                                                   |
+/*****************************************************************************/
\ No newline at end of file
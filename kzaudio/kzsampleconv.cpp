@@ -0,0 +1,260 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzsampleconv.cpp											          |
+| Desc: block conversion of sample formats to signed 16-bit                   |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#include <math.h>
+#include "kzsampleconv.h"
+#if defined(__AVX2__)
+#  define KZSAMPLECONV_AVX2 1
+#endif
+#if defined(__SSSE3__) || defined(__AVX2__)
+#  define KZSAMPLECONV_SSSE3 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define KZSAMPLECONV_SSE2 1
+#endif
+#if (KZSAMPLECONV_AVX2)
+#  include <immintrin.h>
+#elif (KZSAMPLECONV_SSSE3)
+#  include <tmmintrin.h>
+#elif (KZSAMPLECONV_SSE2)
+#  include <emmintrin.h>
+#endif
+namespace kz {
+
+
+
+	Void ConvertPCM8(const Byte* source, Int16* dest, SizeT count) {
+		SizeT i = 0;
+	#if (KZSAMPLECONV_AVX2)
+		const __m128i bias = _mm_set1_epi8((char)(0x80));
+		for (; i + 16 <= count; i += 16) {
+			__m128i bytes = _mm_xor_si128(_mm_loadu_si128(
+				(const __m128i*)(source + i)), bias);
+			_mm256_storeu_si256((__m256i*)(dest + i),
+				_mm256_slli_epi16(_mm256_cvtepu8_epi16(bytes), 8));
+		}
+	#elif (KZSAMPLECONV_SSE2)
+		const __m128i bias = _mm_set1_epi8((char)(0x80));
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 16 <= count; i += 16) {
+			//flipping the top bit makes the byte signed, it then becomes the high byte
+			__m128i bytes = _mm_xor_si128(_mm_loadu_si128(
+				(const __m128i*)(source + i)), bias);
+			_mm_storeu_si128((__m128i*)(dest + i),     _mm_unpacklo_epi8(zero, bytes));
+			_mm_storeu_si128((__m128i*)(dest + i + 8), _mm_unpackhi_epi8(zero, bytes));
+		}
+	#endif
+		for (; i < count; ++i) {
+			dest[i] = (Int16)(((Int16)(source[i]) - 0x80) << 0x8);
+		}
+	}
+
+
+
+	Void ConvertPCM16(const Byte* source, Int16* dest, SizeT count) {
+	#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+		for (SizeT i = 0; i < count; ++i, source += 2) {
+			dest[i] = (Int16)(source[0] | (source[1] << 0x8));
+		}
+	#else
+		if ((const Void*)(source) != (const Void*)(dest)) {
+			memmove(dest, source, count * sizeof(Int16));
+		}
+	#endif
+	}
+
+
+
+	Void ConvertPCM24(const Byte* source, Int16* dest, SizeT count) {
+		SizeT i = 0;
+	#if (KZSAMPLECONV_SSSE3)
+		//keep the upper two bytes of each 3 byte sample, 4 samples per load
+		const __m128i lower = _mm_setr_epi8(
+			1, 2, 4, 5, 7, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1);
+		const __m128i upper = _mm_setr_epi8(
+			-1, -1, -1, -1, -1, -1, -1, -1, 1, 2, 4, 5, 7, 8, 10, 11);
+		//each load reads 4 bytes past the samples it converts
+		for (; i + 10 <= count; i += 8) {
+			const Byte* bytes = source + i * 3;
+			__m128i a = _mm_loadu_si128((const __m128i*)(bytes));
+			__m128i b = _mm_loadu_si128((const __m128i*)(bytes + 12));
+			_mm_storeu_si128((__m128i*)(dest + i), _mm_or_si128(
+				_mm_shuffle_epi8(a, lower), _mm_shuffle_epi8(b, upper)));
+		}
+	#endif
+		for (source += i * 3; i < count; ++i, source += 3) {
+			dest[i] = (Int16)(source[1] | (source[2] << 0x8));
+		}
+	}
+
+
+
+	Void ConvertPCM32(const Byte* source, Int16* dest, SizeT count) {
+		SizeT i = 0;
+	#if (KZSAMPLECONV_AVX2)
+		for (; i + 16 <= count; i += 16) {
+			__m256i a = _mm256_srai_epi32(_mm256_loadu_si256(
+				(const __m256i*)(source + i * 4)), 16);
+			__m256i b = _mm256_srai_epi32(_mm256_loadu_si256(
+				(const __m256i*)(source + i * 4 + 32)), 16);
+			//the pack works per 128-bit lane, restore the sample order
+			_mm256_storeu_si256((__m256i*)(dest + i), _mm256_permute4x64_epi64(
+				_mm256_packs_epi32(a, b), 0xD8));
+		}
+	#endif
+	#if (KZSAMPLECONV_SSE2)
+		for (; i + 8 <= count; i += 8) {
+			__m128i a = _mm_srai_epi32(_mm_loadu_si128(
+				(const __m128i*)(source + i * 4)), 16);
+			__m128i b = _mm_srai_epi32(_mm_loadu_si128(
+				(const __m128i*)(source + i * 4 + 16)), 16);
+			_mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi32(a, b));
+		}
+	#endif
+		for (source += i * 4; i < count; ++i, source += 4) {
+			dest[i] = (Int16)(source[2] | (source[3] << 0x8));
+		}
+	}
+
+
+
+	/** scale a float sample to 16-bit, clamping values outside [-1, 1]*/
+	static inline Int16 FloatToPCM16(Float sample) {
+		sample = Max(-32768.f, Min(sample * 32768.f, 32767.f));
+		return (Int16)(lrintf(sample));
+	}
+
+
+
+	Void InterleaveFloat(const Float* const* planes, Uint32 nchannels,
+		SizeT nframes, Int16* dest) {
+		SizeT i = 0;
+	#if (KZSAMPLECONV_SSE2)
+		const __m128 scale = _mm_set1_ps(32768.f);
+		const __m128 lower = _mm_set1_ps(-32768.f);
+		const __m128 upper = _mm_set1_ps(32767.f);
+		#define KZ_TOPCM16(p) _mm_cvtps_epi32(_mm_max_ps(lower, \
+			_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(p), scale), upper)))
+
+		if (nchannels == 1) {
+			for (; i + 8 <= nframes; i += 8) {
+				_mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi32(
+					KZ_TOPCM16(planes[0] + i), KZ_TOPCM16(planes[0] + i + 4)));
+			}
+		}
+		else if (nchannels == 2) {
+			for (; i + 8 <= nframes; i += 8) {
+				__m128i left  = _mm_packs_epi32(
+					KZ_TOPCM16(planes[0] + i), KZ_TOPCM16(planes[0] + i + 4));
+				__m128i right = _mm_packs_epi32(
+					KZ_TOPCM16(planes[1] + i), KZ_TOPCM16(planes[1] + i + 4));
+				_mm_storeu_si128((__m128i*)(dest + i * 2),     _mm_unpacklo_epi16(left, right));
+				_mm_storeu_si128((__m128i*)(dest + i * 2 + 8), _mm_unpackhi_epi16(left, right));
+			}
+		}
+		#undef KZ_TOPCM16
+	#endif
+		for (; i < nframes; ++i) {
+			for (Uint32 c = 0; c < nchannels; ++c) {
+				dest[i * nchannels + c] = FloatToPCM16(planes[c][i]);
+			}
+		}
+	}
+
+
+
+	Void InterleaveFloat(const Float* const* planes, Uint32 nchannels,
+		SizeT nframes, Float* dest) {
+		SizeT i = 0;
+		if (nchannels == 1) {
+			memcpy(dest, planes[0], nframes * sizeof(Float));
+			return;
+		}
+	#if (KZSAMPLECONV_SSE2)
+		if (nchannels == 2) {
+			for (; i + 4 <= nframes; i += 4) {
+				__m128 left  = _mm_loadu_ps(planes[0] + i);
+				__m128 right = _mm_loadu_ps(planes[1] + i);
+				_mm_storeu_ps(dest + i * 2,     _mm_unpacklo_ps(left, right));
+				_mm_storeu_ps(dest + i * 2 + 4, _mm_unpackhi_ps(left, right));
+			}
+		}
+	#endif
+		for (; i < nframes; ++i) {
+			for (Uint32 c = 0; c < nchannels; ++c) {
+				dest[i * nchannels + c] = planes[c][i];
+			}
+		}
+	}
+
+
+
+	Void InterleavePCM(const Int32* const* planes, Uint32 nchannels,
+		SizeT nframes, Uint32 bits, Int16* dest) {
+		//one of the shifts is always zero
+		const Int32 right = bits > 16 ? (Int32)(bits - 16) : 0;
+		const Int32 left  = bits < 16 ? (Int32)(16 - bits) : 0;
+		SizeT i = 0;
+	#if (KZSAMPLECONV_SSE2)
+		const __m128i rcount = _mm_cvtsi32_si128(right);
+		const __m128i lcount = _mm_cvtsi32_si128(left);
+		#define KZ_TOPCM16(p) _mm_sll_epi32(_mm_sra_epi32( \
+			_mm_loadu_si128((const __m128i*)(p)), rcount), lcount)
+
+		if (nchannels == 1) {
+			for (; i + 8 <= nframes; i += 8) {
+				_mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi32(
+					KZ_TOPCM16(planes[0] + i), KZ_TOPCM16(planes[0] + i + 4)));
+			}
+		}
+		else if (nchannels == 2) {
+			for (; i + 8 <= nframes; i += 8) {
+				__m128i leftSamples  = _mm_packs_epi32(
+					KZ_TOPCM16(planes[0] + i), KZ_TOPCM16(planes[0] + i + 4));
+				__m128i rightSamples = _mm_packs_epi32(
+					KZ_TOPCM16(planes[1] + i), KZ_TOPCM16(planes[1] + i + 4));
+				_mm_storeu_si128((__m128i*)(dest + i * 2),     _mm_unpacklo_epi16(leftSamples, rightSamples));
+				_mm_storeu_si128((__m128i*)(dest + i * 2 + 8), _mm_unpackhi_epi16(leftSamples, rightSamples));
+			}
+		}
+		#undef KZ_TOPCM16
+	#endif
+		for (; i < nframes; ++i) {
+			for (Uint32 c = 0; c < nchannels; ++c) {
+				dest[i * nchannels + c] = (Int16)((planes[c][i] >> right) * (1 << left));
+			}
+		}
+	}
+
+
+
+	CONVERTPROC GetPCMConverter(Uint32 bytesPerSample) {
+		switch (bytesPerSample) {
+		case 1:  return ConvertPCM8;
+		case 2:  return ConvertPCM16;
+		case 3:  return ConvertPCM24;
+		case 4:  return ConvertPCM32;
+		default: return NULL;
+		}
+	}
+};
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/
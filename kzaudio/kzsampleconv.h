@@ -0,0 +1,77 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzsampleconv.h												          |
+| Desc: block conversion of sample formats to signed 16-bit                   |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#ifndef __KZSAMPLECONV_H__
+#define __KZSAMPLECONV_H__
+
+#include "kzbasetypes.h"
+namespace kz {
+
+
+
+	/** converts count samples from source into dest*/
+	typedef Void (*CONVERTPROC)(const Byte* source, Int16* dest, SizeT count);
+
+
+	/** convert unsigned 8-bit pcm to signed 16-bit*/
+	extern Void ConvertPCM8(const Byte* source, Int16* dest, SizeT count);
+
+	/** convert little-endian signed 16-bit pcm to native signed 16-bit*/
+	extern Void ConvertPCM16(const Byte* source, Int16* dest, SizeT count);
+
+	/** convert little-endian signed 24-bit pcm to signed 16-bit*/
+	extern Void ConvertPCM24(const Byte* source, Int16* dest, SizeT count);
+
+	/** convert little-endian signed 32-bit pcm to signed 16-bit*/
+	extern Void ConvertPCM32(const Byte* source, Int16* dest, SizeT count);
+
+
+	/** interleave planar float samples, clamped to [-1, 1] and converted
+		to signed 16-bit
+		@param planes:    one array of nframes samples per channel
+		@param nchannels: number of planes
+		@param nframes:   samples in each plane
+		@param dest:      receives nframes * nchannels samples*/
+	extern Void InterleaveFloat(const Float* const* planes, Uint32 nchannels,
+		SizeT nframes, Int16* dest);
+
+	/** interleave planar float samples, keeping them as float*/
+	extern Void InterleaveFloat(const Float* const* planes, Uint32 nchannels,
+		SizeT nframes, Float* dest);
+
+
+	/** interleave planar integer samples of the given width (4 to 32
+		bits, held in 32-bit ints) and convert them to signed 16-bit
+		@param planes:    one array of nframes samples per channel
+		@param nchannels: number of planes
+		@param nframes:   samples in each plane
+		@param bits:      significant bits of each sample
+		@param dest:      receives nframes * nchannels samples*/
+	extern Void InterleavePCM(const Int32* const* planes, Uint32 nchannels,
+		SizeT nframes, Uint32 bits, Int16* dest);
+
+
+	/** returns the conversion for little-endian pcm samples of the
+		given width in bytes (1 to 4), or NULL if unsupported*/
+	extern CONVERTPROC GetPCMConverter(Uint32 bytesPerSample);
+};
+/*****************************************************************************/
+#endif//EOF                                                                   |
+/*****************************************************************************/
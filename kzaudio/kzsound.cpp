@@ -20,6 +20,7 @@
 ******************************************************************************/
 #include <al/al.h>
 #include <al/alc.h>   
+#include "kzresidency.h"
 #include "kzsoundbuffer.h"
 #include "kzsound.h" 
 namespace kz {
@@ -28,20 +29,25 @@ namespace kz {
 
 	Sound::Sound() {
 		m_buffer = NULL;
+		m_prevSound = NULL;
+		m_nextSound = NULL;
+		m_initialVolume = 100;
 		alGenSources(1, &m_alSourceId);
 		alSourcei(m_alSourceId, AL_BUFFER, 0);
 	}
 
-	Sound::Sound(const SoundBuffer* buffer) {
+	Sound::Sound(const SoundBuffer* buffer) :
+		Sound() {
 		SetBuffer(buffer);
 	}
 
 
 
-	Sound::Sound(const Sound& copy) {
-		alGenSources(1, &m_alSourceId);
-		alSourcei(m_alSourceId, AL_BUFFER, 0);
+	Sound::Sound(const Sound& copy) :
+		Sound() {
+		m_initialVolume = copy.m_initialVolume;
 		SetVolume(copy.GetVolume());
+		SetLooping(copy.IsLooping());
 		if (copy.m_buffer) {
 			SetBuffer(copy.m_buffer);
 		}
@@ -53,13 +59,11 @@ namespace kz {
 		if (this == &copy) {
 			return *this;
 		}
+		m_initialVolume = copy.m_initialVolume;
 		SetVolume(copy.GetVolume());
+		SetLooping(copy.IsLooping());
 
-		if (m_buffer) {
-			Stop();
-			m_buffer->m_registeredSounds.erase(this);
-			m_buffer = NULL;
-		}
+		ResetBuffer();
 		if (copy.m_buffer) {
 			SetBuffer(copy.m_buffer);
 		}
@@ -68,18 +72,72 @@ namespace kz {
 
 
 
+	Sound::Sound(Sound&& other) noexcept {
+		m_buffer = NULL;
+		m_prevSound = NULL;
+		m_nextSound = NULL;
+		m_alSourceId = 0;
+		MoveFrom(other);
+	}
+
+
+
+	Sound& Sound::operator=(Sound&& other) noexcept {
+		if (this == &other) {
+			return *this;
+		}
+		ResetBuffer();
+		if (m_alSourceId) {
+			alDeleteSources(1, &m_alSourceId);
+		}
+		MoveFrom(other);
+		return *this;
+	}
+
+
+
 	Sound::~Sound() {
-		Stop();
-		if (m_buffer) {
-			m_buffer->m_registeredSounds.erase(this);
+		if (!m_alSourceId) {
+			return;
 		}
-		alSourcei(m_alSourceId, AL_BUFFER, 0);
+		ResetBuffer();
 		alDeleteSources(1, &m_alSourceId);
 	}
 
 
 
+	Void Sound::MoveFrom(Sound& other) noexcept {
+		m_initialVolume = other.m_initialVolume;
+		m_alSourceId = other.m_alSourceId;
+		other.m_alSourceId = 0;
+
+		//take the place of the other sound in its buffer's list
+		m_buffer = other.m_buffer;
+		m_prevSound = other.m_prevSound;
+		m_nextSound = other.m_nextSound;
+		if (m_buffer) {
+			if (m_prevSound)
+				m_prevSound->m_nextSound = this;
+			else m_buffer->m_firstSound = this;
+			if (m_nextSound)
+				m_nextSound->m_prevSound = this;
+		}
+		other.m_buffer = NULL;
+		other.m_prevSound = NULL;
+		other.m_nextSound = NULL;
+	}
+
+
+
 	Void Sound::Play() {
+		//reloads the buffer if it was evicted, re-attaching this source.
+		//a buffer evicted by a manager since removed reloads on its own
+		if (m_buffer && m_buffer->m_manager) {
+			m_buffer->m_manager->Touch(m_buffer);
+		}
+		else if (m_buffer && m_buffer->m_evicted) {
+			const_cast<SoundBuffer*>(m_buffer)->Reload();
+		}
 		alSourcePlay(m_alSourceId);
 	}
 
@@ -115,6 +173,19 @@ namespace kz {
 
 
 
+	Void Sound::SetLooping(Bool loop) {
+		alSourcei(m_alSourceId, AL_LOOPING, loop ? AL_TRUE : AL_FALSE);
+	}
+
+
+	Bool Sound::IsLooping() const {
+		Int32 looping = AL_FALSE;
+		alGetSourcei(m_alSourceId, AL_LOOPING, &looping);
+		return looping == AL_TRUE;
+	}
+
+
+
 	Void Sound::SetMuted(Bool mute) {
 		SetVolume(mute ? 0 : m_initialVolume);
 	}
@@ -148,11 +219,11 @@ namespace kz {
 	Void Sound::SetBuffer(const SoundBuffer* buffer) {
 		if (m_buffer) {
 			Stop();
-			m_buffer->m_registeredSounds.erase(this);
+			UnlinkBuffer();
 		}
 		m_buffer = buffer;
-		m_buffer->m_registeredSounds.insert(this);
-		alSourcei(m_alSourceId, AL_BUFFER, (Int32)m_buffer->m_bufferId);
+		LinkBuffer();
+		AttachSource();
 	}
 
 
@@ -161,10 +232,45 @@ namespace kz {
 		Stop();
 		if (m_buffer) {
 			alSourcei(m_alSourceId, AL_BUFFER, 0);
-			m_buffer->m_registeredSounds.erase(this);
+			UnlinkBuffer();
 			m_buffer = NULL;
 		}
 	}
+
+
+
+	Void Sound::DetachSource() {
+		Stop();
+		alSourcei(m_alSourceId, AL_BUFFER, 0);
+	}
+
+
+
+	Void Sound::AttachSource() {
+		alSourcei(m_alSourceId, AL_BUFFER, (Int32)m_buffer->m_bufferId);
+	}
+
+
+
+	Void Sound::LinkBuffer() {
+		m_prevSound = NULL;
+		m_nextSound = m_buffer->m_firstSound;
+		if (m_nextSound)
+			m_nextSound->m_prevSound = this;
+		m_buffer->m_firstSound = this;
+	}
+
+
+
+	Void Sound::UnlinkBuffer() {
+		if (m_prevSound)
+			m_prevSound->m_nextSound = m_nextSound;
+		else m_buffer->m_firstSound = m_nextSound;
+		if (m_nextSound)
+			m_nextSound->m_prevSound = m_prevSound;
+		m_prevSound = NULL;
+		m_nextSound = NULL;
+	}
 };
 /******************************************************************************
 //EOF                                                                         |
@@ -36,6 +36,11 @@ namespace kz {
 		Sound();
 		Sound(const Sound&);
 		Sound& operator=(const Sound&);
+
+		/** take over the source of another sound, it keeps playing.
+			the moved-from sound may only be assigned to or destroyed.*/
+		Sound(Sound&& other) noexcept;
+		Sound& operator=(Sound&& other) noexcept;
 		explicit Sound(const SoundBuffer*);
 		explicit Sound(SoundBuffer&&) = delete;
 		Void SetBuffer(SoundBuffer&&) = delete;
@@ -66,6 +71,15 @@ namespace kz {
 		/** returns true if sound is stopped else false*/
 		Bool IsStopped() const;
 
+		/**	set whether the sound repeats until stopped. buffers with loop
+			points play up to the loop end, then repeat from the loop start,
+			when the device has AL_SOFT_loop_points. elsewhere the whole
+			buffer repeats.*/
+		Void SetLooping(Bool loop);
+
+		/**	returns true if the sound repeats until stopped*/
+		Bool IsLooping() const;
+
 		/**	mute or unmute the audio source.
 			@param mute: true to mute, false to unmute*/
 		Void SetMuted(Bool mute);
@@ -84,7 +98,16 @@ namespace kz {
 
 
 	private:
+		friend class SoundBuffer;
+		Void DetachSource();
+		Void AttachSource();
+		Void LinkBuffer();
+		Void UnlinkBuffer();
+		Void MoveFrom(Sound& other) noexcept;
+
 		const SoundBuffer* m_buffer;
+		Sound*             m_prevSound; //other sounds of the buffer, linked
+		Sound*             m_nextSound; //in place so attaching never allocates
 		Int32              m_initialVolume;
 		Uint32             m_alSourceId;
 	};
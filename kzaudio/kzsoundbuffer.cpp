@@ -20,79 +20,459 @@
 ******************************************************************************/
 #include <al/al.h>
 #include <al/alc.h>   
+#include <atomic>
+#include "kzaudiocache.h"
 #include "kzaudiodevice.h"
 #include "kzaudiofile.h"
+#include "kziostream.h"
+#include "kzresidency.h"
 #include "kzsound.h"
 #include "kzsoundbuffer.h"
+#include "kzthreadpool.h"
 namespace kz {
 
+//shortest range of frames worth a thread of its own
+#define KZSOUNDBUFFER_SEGMENTFRAMES 0x40000
 
 
-	SoundBuffer::SoundBuffer() {
+
+	SoundBuffer::SoundBuffer() :
+		SoundBuffer(Staging()) {
 		alGenBuffers(1, &m_bufferId);
 	}
 
 
 
+	SoundBuffer::SoundBuffer(Staging) {
+		m_residency = SAMPLERESIDENCY_CPU;
+		m_sourceView = NULL;
+		m_sourceSize = 0;
+		m_sampleCount = 0;
+		m_directFile = NULL;
+		m_encoding = AUDIOENCODING_PCM16;
+		m_framesPerBlock = 0;
+		m_encodedSamples = 0;
+		m_loopStart = 0;
+		m_loopEnd = 0;
+		m_nchannels = 0;
+		m_sampleRate = 0;
+		m_deviceBytes = 0;
+		m_evicted = false;
+		m_manager = NULL;
+		m_prevManaged = NULL;
+		m_nextManaged = NULL;
+		m_managedBytes = 0;
+		m_bufferId = 0;
+		m_firstSound = NULL;
+		m_serial = false;
+	}
+
+
+
 	SoundBuffer::SoundBuffer(const SoundBuffer& copy) :
-		m_sampleData(copy.m_sampleData),
-		m_length(copy.m_length) {
+		m_residency(copy.m_residency),
+		m_sourcePath(copy.m_sourcePath),
+		m_sourceData(copy.m_sourceData),
+		m_sourceView(copy.m_sourceView),
+		m_sourceSize(copy.m_sourceSize),
+		m_sampleCount(0),
+		m_directFile(NULL),
+		m_encodedData(copy.m_encodedData),
+		m_encoding(copy.m_encoding),
+		m_framesPerBlock(copy.m_framesPerBlock),
+		m_encodedSamples(copy.m_encodedSamples),
+		m_loopStart(copy.m_loopStart),
+		m_loopEnd(copy.m_loopEnd),
+		m_nchannels(0),
+		m_sampleRate(0),
+		m_deviceBytes(0),
+		m_evicted(false),
+		m_manager(NULL),
+		m_prevManaged(NULL),
+		m_nextManaged(NULL),
+		m_managedBytes(0),
+		m_length(copy.m_length),
+		m_firstSound(NULL),
+		m_serial(false) {
+
+		//samples of a mapped file are copied, the mapping stays with the original
+		SizeT count = 0;
+		const Int16* samples = copy.GetSamples(&count);
+		if (samples)
+			m_sampleData.assign(samples, samples + count);
+		else if (m_encodedData.empty())
+			RestoreSamples();
 
 		alGenBuffers(1, &m_bufferId);
-		AudioDesc desc;
-		copy.GetDesc(&desc);
-		Update(desc.nchannels, desc.sampleRate);
+		if (Update(copy.m_nchannels, copy.m_sampleRate) &&
+			m_residency == SAMPLERESIDENCY_DEVICE) {
+			ReleaseSamples();
+		}
 	}
 
 
 
 	SoundBuffer& SoundBuffer::operator=(const SoundBuffer& copy) {
+		//sounds of the old samples are detached when temp is destroyed,
+		//the buffer stays with its ResidencyManager
 		SoundBuffer temp(copy);
-		std::swap(m_sampleData, temp.m_sampleData);
-		std::swap(m_bufferId, temp.m_bufferId);
-		std::swap(m_length, temp.m_length);
-		std::swap(m_registeredSounds, temp.m_registeredSounds);
+		Swap(temp);
 		return *this;
 	}
 
 
 
-	SoundBuffer::~SoundBuffer() {
-		SOUNDSET sounds;
-		sounds.swap(m_registeredSounds);
+	SoundBuffer::SoundBuffer(SoundBuffer&& other) noexcept :
+		SoundBuffer(Staging()) {
+		Swap(other);
+		if (other.m_manager) {
+			other.m_manager->Rebind(&other, this);
+		}
+	}
+
+
+
+	SoundBuffer& SoundBuffer::operator=(SoundBuffer&& other) noexcept {
+		if (this == &other) {
+			return *this;
+		}
+		SoundBuffer temp(std::move(other));
+		Swap(temp);
+		if (m_manager) {
+			m_manager->Forget(this);
+			m_manager = NULL;
+		}
+		if (temp.m_manager) {
+			temp.m_manager->Rebind(&temp, this);
+		}
+		return *this;
+	}
+
+
+
+	Void SoundBuffer::Swap(SoundBuffer& other) noexcept {
+		std::swap(m_residency, other.m_residency);
+		std::swap(m_sourcePath, other.m_sourcePath);
+		std::swap(m_sourceData, other.m_sourceData);
+		std::swap(m_sourceView, other.m_sourceView);
+		std::swap(m_sourceSize, other.m_sourceSize);
+		std::swap(m_sampleCount, other.m_sampleCount);
+		std::swap(m_sampleData, other.m_sampleData);
+		std::swap(m_directFile, other.m_directFile);
+		std::swap(m_encodedData, other.m_encodedData);
+		std::swap(m_encoding, other.m_encoding);
+		std::swap(m_framesPerBlock, other.m_framesPerBlock);
+		std::swap(m_encodedSamples, other.m_encodedSamples);
+		std::swap(m_loopStart, other.m_loopStart);
+		std::swap(m_loopEnd, other.m_loopEnd);
+		std::swap(m_nchannels, other.m_nchannels);
+		std::swap(m_sampleRate, other.m_sampleRate);
+		std::swap(m_deviceBytes, other.m_deviceBytes);
+		std::swap(m_evicted, other.m_evicted);
+		std::swap(m_bufferId, other.m_bufferId);
+		std::swap(m_length, other.m_length);
+
+		//sources follow their device buffer
+		std::swap(m_firstSound, other.m_firstSound);
+		for (Sound* sound = m_firstSound; sound; sound = sound->m_nextSound) {
+			sound->m_buffer = this;
+		}
+		for (Sound* sound = other.m_firstSound; sound; sound = sound->m_nextSound) {
+			sound->m_buffer = &other;
+		}
+		UpdateManaged();
+		other.UpdateManaged();
+	}
 
-		for (auto* soundPtr : sounds) {
-			soundPtr->ResetBuffer();
+
+
+	SoundBuffer::~SoundBuffer() {
+		if (m_manager) {
+			m_manager->Forget(this);
+		}
+		while (m_firstSound) {
+			m_firstSound->ResetBuffer();
 		}
 		if (m_bufferId) {
 			alDeleteBuffers(1, &m_bufferId);
 		}
+		ReleaseData();
 	}
 
 
 
 	Bool SoundBuffer::Load(const String& filename) {
+		return Load(filename, NULL, 0);
+	}
+
+
+
+	Bool SoundBuffer::Load(const String& filename, Lpcvoid data, SizeT nbytes) {
+		ReleaseSource();
+		m_sourcePath = filename;
+
+		AudioDesc desc;
+		Bool loaded = DecodeFile(filename, &desc, data, nbytes) &&
+			Update(desc.nchannels, desc.sampleRate);
+		if (loaded && m_residency == SAMPLERESIDENCY_DEVICE) {
+			ReleaseSamples();
+		}
+		return loaded;
+	}
+
+
+
+	Bool SoundBuffer::DecodeFile(const String& filename, AudioDesc* desc,
+		Lpcvoid data, SizeT nbytes) {
+		//a sound decoded earlier is mapped from the cache instead, or read
+		//with stdio where files can not be mapped
+		const String cachePath = GetAudioCachePath(filename);
+		IOStream*    stream    = NULL;
+		if (!cachePath.empty()) {
+			stream = OpenMappedStream(cachePath);
+			if (!stream)
+				stream = OpenStdioStream(cachePath);
+		}
+		AudioFile*   file      = new AudioFile();
+		const Bool   cached    = stream && file->Load(stream);
+		if (!cached && !(data ? file->Load(data, nbytes) : file->Load(filename))) {
+			delete file;
+			return false;
+		}
+		file->GetDesc(desc);
+		if (cached) {
+			TouchAudioCache(cachePath);
+		}
+		//contents read by the caller only last for the call, samples that
+		//can be uploaded in place are mapped from the file instead
+		if (!cached && data && file->GetDirectSamples() &&
+			!(file->Load(filename) && file->GetDirectSamples())) {
+			file->Load(data, nbytes);
+		}
+		else if (file->GetDirectSamples()) {
+			SetDirect(file);
+			return true;
+		}
+		Bool decoded = Decode(file, *desc);
+		delete file;
+
+		if (decoded && !cached && !cachePath.empty() && !m_sampleData.empty()) {
+			WriteAudioCache(cachePath, m_sampleData.data(), m_sampleData.size(),
+				desc->nchannels, desc->sampleRate, m_loopStart, m_loopEnd);
+		}
+		return decoded;
+	}
+
+
+
+	Bool SoundBuffer::Load(Lpcvoid data, SizeT nbytes) {
+		ReleaseSource();
+
+		AudioFile file;
+		if (!file.Load(data, nbytes) || !Initialize(&file)) {
+			return false;
+		}
+		if (m_residency == SAMPLERESIDENCY_DEVICE) {
+			//the caller's data is only valid for this call, keep the
+			//encoded file to decode the samples again from
+			m_sourceData.assign((const Byte*)(data), (const Byte*)(data) + nbytes);
+			ReleaseSamples();
+		}
+		return true;
+	}
+
+
+
+	Bool SoundBuffer::LoadMapped(Lpcvoid data, SizeT nbytes) {
+		ReleaseSource();
+
 		AudioFile file;
-		if (file.Load(filename))
-			return Initialize(&file);
+		if (!file.Load(data, nbytes) || !Initialize(&file)) {
+			return false;
+		}
+		m_sourceView = (const Byte*)(data);
+		m_sourceSize = nbytes;
+		if (m_residency == SAMPLERESIDENCY_DEVICE) {
+			ReleaseSamples();
+		}
+		return true;
+	}
+
+
+
+	Void SoundBuffer::ReleaseSource() {
+		m_sourcePath.clear();
+		BYTEDATA().swap(m_sourceData);
+		m_sourceView = NULL;
+		m_sourceSize = 0;
+	}
+
+
+
+	Bool SoundBuffer::Adopt(SoundBuffer& staging, const String& filename,
+		const AudioDesc& desc) {
+		ReleaseSamples();
+		std::swap(m_sampleData, staging.m_sampleData);
+		std::swap(m_directFile, staging.m_directFile);
+		std::swap(m_encodedData, staging.m_encodedData);
+		std::swap(m_encoding, staging.m_encoding);
+		std::swap(m_framesPerBlock, staging.m_framesPerBlock);
+		std::swap(m_encodedSamples, staging.m_encodedSamples);
+		std::swap(m_loopStart, staging.m_loopStart);
+		std::swap(m_loopEnd, staging.m_loopEnd);
+		ReleaseSource();
+		m_sourcePath = filename;
+
+		Bool loaded = Update(desc.nchannels, desc.sampleRate);
+		if (loaded && m_residency == SAMPLERESIDENCY_DEVICE) {
+			ReleaseSamples();
+		}
+		return loaded;
+	}
+
+
+
+	Void SoundBuffer::GetMemoryUsage(Uint64* cpuBytes, Uint64* deviceBytes) const {
+		SizeT count = 0;
+		*cpuBytes = m_sampleData.size() * sizeof(Int16) + m_encodedData.size() +
+			m_sourceData.size();
+		if (m_directFile && GetSamples(&count))
+			*cpuBytes += count * sizeof(Int16);
+		*deviceBytes = m_deviceBytes;
+	}
+
+
+
+	Bool SoundBuffer::IsEvicted() const {
+		return m_evicted;
+	}
+
+
+
+	Bool SoundBuffer::Evict() {
+		if (m_evicted || m_deviceBytes == 0 ||
+			(m_sourcePath.empty() && m_sourceData.empty() && !m_sourceView)) {
+			return false;
+		}
+		//sources keep their buffer, they are only detached from the
+		//device buffer so it can be deleted
+		for (Sound* sound = m_firstSound; sound; sound = sound->m_nextSound) {
+			sound->DetachSource();
+		}
+		alDeleteBuffers(1, &m_bufferId);
+		alGenBuffers(1, &m_bufferId);
+		ReleaseSamples();
+		m_deviceBytes = 0;
+		m_evicted     = true;
+		UpdateManaged();
+		return true;
+	}
+
+
+
+	Bool SoundBuffer::IsInUse() const {
+		for (Sound* sound = m_firstSound; sound; sound = sound->m_nextSound) {
+			if (sound->IsPlaying() || sound->IsPaused())
+				return true;
+		}
 		return false;
 	}
 
 
 
-	Void SoundBuffer::GetDesc(AudioDesc* desc) const {
-		Int32 sampleRate, channelCount;
+	Bool SoundBuffer::Reload() {
+		if (!m_evicted) {
+			return true;
+		}
+		if (!RestoreSamples() || !Update(m_nchannels, m_sampleRate)) {
+			return false;
+		}
+		if (m_residency == SAMPLERESIDENCY_DEVICE) {
+			ReleaseSamples();
+		}
+		return true;
+	}
+
+
+
+	Void SoundBuffer::SetResidency(SAMPLERESIDENCY residency) {
+		m_residency = residency;
+	}
+
+
+
+	SAMPLERESIDENCY SoundBuffer::GetResidency() const {
+		return m_residency;
+	}
+
+
+
+	Bool SoundBuffer::RestoreSamples() {
+		const Bool restored = DecodeSource();
+		UpdateManaged();
+		return restored;
+	}
+
+
+
+	Bool SoundBuffer::DecodeSource() {
+		SizeT count = 0;
+		if (GetSamples(&count) || !m_encodedData.empty()) {
+			return true;
+		}
+		AudioDesc desc;
+		if (!m_sourcePath.empty()) {
+			return DecodeFile(m_sourcePath, &desc);
+		}
+		const Byte* source = m_sourceView ? m_sourceView : m_sourceData.data();
+		const SizeT nbytes = m_sourceView ? m_sourceSize : m_sourceData.size();
+		AudioFile* file = new AudioFile();
+		if (nbytes == 0 || !file->Load(source, nbytes)) {
+			delete file;
+			return false;
+		}
+		file->GetDesc(&desc);
+		if (file->GetDirectSamples()) {
+			SetDirect(file);
+			return true;
+		}
+		Bool decoded = Decode(file, desc);
+		delete file;
+		return decoded;
+	}
+
 
-		desc->samples = m_sampleData.empty() ? NULL : m_sampleData.data();
-		desc->sampleCount = m_sampleData.size();
 
-		alGetBufferi(m_bufferId, AL_FREQUENCY, &sampleRate);
-		desc->sampleRate = (Uint32)(sampleRate);
+	Void SoundBuffer::GetDesc(AudioDesc* desc) const {
+		const Uint32 sampleRate = m_sampleRate;
+
+		SizeT sampleCount = 0;
+		desc->samples = GetSamples(&sampleCount);
+		desc->sampleCount = sampleCount;
 
-		alGetBufferi(m_bufferId, AL_CHANNELS, &channelCount);
-		desc->nchannels = (Uint32)(channelCount);
+		//kept from the last upload, the device buffer is empty when evicted
+		desc->sampleRate = sampleRate;
+		desc->nchannels  = m_nchannels;
 
 		desc->length = m_length;
+
+		Uint64 loopStart = 0, loopEnd = 0;
+		desc->loopEnabled = sampleRate > 0 && GetLoopPoints(&loopStart, &loopEnd);
+		desc->loopStart   = desc->loopEnabled ? TimeValue::FromSeconds(
+			(Float)(loopStart) / (Float)(sampleRate)) : TimeValue();
+		desc->loopEnd     = desc->loopEnabled ? TimeValue::FromSeconds(
+			(Float)(loopEnd) / (Float)(sampleRate)) : TimeValue();
+	}
+
+
+
+	Bool SoundBuffer::GetLoopPoints(Uint64* start, Uint64* end) const {
+		if (m_loopEnd == 0) {
+			return false;
+		}
+		*start = m_loopStart;
+		*end   = m_loopEnd;
+		return true;
 	}
 
 
@@ -100,46 +480,213 @@ namespace kz {
 	Bool SoundBuffer::Initialize(AudioFile* file) {
 		AudioDesc desc;
 		file->GetDesc(&desc);
+		return Decode(file, desc) && Update(desc.nchannels, desc.sampleRate);
+	}
+
+
+
+	Bool SoundBuffer::Decode(AudioFile* file, const AudioDesc& desc) {
+		ReleaseData();
+
+		Uint32 framesPerBlock = 0;
+		Uint64 nbytes = 0;
+		AUDIOENCODING encoding = file->GetEncoding(&framesPerBlock, &nbytes);
+		m_loopStart = m_loopEnd = 0;
+		file->GetLoopPoints(&m_loopStart, &m_loopEnd);
+		if (encoding != AUDIOENCODING_PCM16 && AudioDevice::GetEncodedFormat(
+			encoding, desc.nchannels, framesPerBlock) != 0) {
+			//the device decodes the blocks itself, keep them compressed
+			m_encodedData.resize((SizeT)(nbytes));
+			if (!file->ReadEncoded(m_encodedData.data())) {
+				m_encodedData.clear();
+				return false;
+			}
+			SAMPLEDATA().swap(m_sampleData);
+			m_encoding       = encoding;
+			m_framesPerBlock = framesPerBlock;
+			m_encodedSamples = desc.sampleCount;
+			return true;
+		}
 		m_sampleData.resize((SizeT)(desc.sampleCount));
-		if (file->Read(m_sampleData.data(), desc.sampleCount) == desc.sampleCount)
-			return Update(desc.nchannels, desc.sampleRate);
-		return false;
+		if (DecodeSegments(file, desc))
+			return true;
+
+		//segments decode through files of their own, this one is still at
+		//frame 0. seeking would make an ogg file index all of its pages
+		return file->Read(m_sampleData.data(), desc.sampleCount) == desc.sampleCount;
 	}
 
 
 
-	Bool SoundBuffer::Update(Uint32 nchannels, Uint32 sampleRate) {
-		if (!nchannels || !sampleRate) {
+	Bool SoundBuffer::DecodeSegments(AudioFile* file, const AudioDesc& desc) {
+		SizeT   nbytes = 0;
+		Lpcvoid data   = file->GetData(&nbytes);
+		if (m_serial || !data || !file->SupportsSegments() || desc.nchannels == 0) {
+			return false;
+		}
+		const Uint64 nframes   = desc.sampleCount / desc.nchannels;
+		const Uint64 nsegments = Min<Uint64>(std::thread::hardware_concurrency(),
+			nframes / KZSOUNDBUFFER_SEGMENTFRAMES);
+		if (nsegments < 2) {
 			return false;
 		}
+		//every segment opens its own file over the same data and decodes
+		//its frames straight into place, the first runs on this thread
+		std::atomic<Bool> success(true);
+		auto decode = [&](Uint64 segment) {
+			const Uint64 first = nframes * segment / nsegments;
+			const Uint64 last  = nframes * (segment + 1) / nsegments;
+			const Uint64 count = (last - first) * desc.nchannels;
+
+			AudioFile part;
+			if (!part.Load(data, nbytes)) {
+				success = false;
+				return;
+			}
+			part.Seek(first * desc.nchannels);
+			if (part.Read(m_sampleData.data() + first * desc.nchannels, count) != count)
+				success = false;
+		};
+		{
+			ThreadPool pool((Uint32)(nsegments - 1));
+			for (Uint64 segment = 1; segment < nsegments; ++segment)
+				pool.Submit([&decode, segment]() { decode(segment); });
+			decode(0);
+		}
+		return success;
+	}
+
+
+
+	Void SoundBuffer::SetDirect(AudioFile* file) {
+		ReleaseData();
+		SAMPLEDATA().swap(m_sampleData);
+
+		//the file keeps the samples mapped for as long as the buffer lives
+		m_directFile = file;
+		m_loopStart = m_loopEnd = 0;
+		file->GetLoopPoints(&m_loopStart, &m_loopEnd);
+	}
+
+
+
+	Void SoundBuffer::ReleaseData() {
+		if (m_directFile) {
+			delete m_directFile;
+			m_directFile = NULL;
+		}
+		BYTEDATA().swap(m_encodedData);
+		UpdateManaged();
+	}
+
+
+
+	Void SoundBuffer::ReleaseSamples() {
+		ReleaseData();
+		SAMPLEDATA().swap(m_sampleData);
+		UpdateManaged();
+	}
+
+
+
+	Void SoundBuffer::UpdateManaged() {
+		if (m_manager) {
+			m_manager->Account(this);
+		}
+	}
+
+
+
+	const Int16* SoundBuffer::GetSamples(SizeT* count) const {
+		if (!m_encodedData.empty()) {
+			//only the device holds decoded samples
+			*count = (SizeT)(m_encodedSamples);
+			return NULL;
+		}
+		if (m_directFile) {
+			AudioDesc desc;
+			m_directFile->GetDesc(&desc);
+			*count = (SizeT)(desc.sampleCount);
+			return m_directFile->GetDirectSamples();
+		}
 		if (m_sampleData.empty()) {
+			//freed after the upload, see SetResidency
+			*count = (SizeT)(m_sampleCount);
+			return NULL;
+		}
+		*count = m_sampleData.size();
+		return m_sampleData.data();
+	}
+
+
+
+	Bool SoundBuffer::Update(Uint32 nchannels, Uint32 sampleRate) {
+		if (!nchannels || !sampleRate) {
 			return false;
 		}
+		SizeT   sampleCount = 0;
+		Lpcvoid data        = GetSamples(&sampleCount);
+		SizeT   nbytes      = sampleCount * sizeof(Int16);
+		Int32   format      = 0;
+
 		//check if the format is valid
-		Int32 format = AudioDevice::GetFormat(nchannels);
-		if (format == 0) {
+		if (!m_encodedData.empty()) {
+			data   = m_encodedData.data();
+			nbytes = m_encodedData.size();
+			format = AudioDevice::GetEncodedFormat(
+				m_encoding, nchannels, m_framesPerBlock);
+		}
+		else format = AudioDevice::GetFormat(nchannels);
+
+		if (!data || sampleCount == 0 || format == 0) {
 			return false;
 		}
-		//copy the list of sounds so we can reattach later
-		const SOUNDSET soundsCopy(m_registeredSounds);
-		for (auto* soundPtr : soundsCopy) {
-			soundPtr->ResetBuffer();
+		//sources are detached while the buffer is filled, they stay linked
+		for (Sound* sound = m_firstSound; sound; sound = sound->m_nextSound) {
+			sound->DetachSource();
+		}
+		//the buffer of a moved-from SoundBuffer is created on its next load
+		if (!m_bufferId) {
+			alGenBuffers(1, &m_bufferId);
+		}
+		//blocks of any size other than the default need the unpack alignment
+		const Bool unpackBlocks = !m_encodedData.empty() &&
+			alIsExtensionPresent("AL_SOFT_block_alignment");
+		const Int32 unpackAlignment = unpackBlocks ?
+			alGetEnumValue("AL_UNPACK_BLOCK_ALIGNMENT_SOFT") : 0;
+		if (unpackBlocks) {
+			alBufferi(m_bufferId, unpackAlignment, (Int32)(m_framesPerBlock));
 		}
 		//fill the buffer 
 		alBufferData(m_bufferId,
 			format,
-			m_sampleData.data(),
-			(Int32)(m_sampleData.size() * sizeof(Int16)),
+			data,
+			(Int32)(nbytes),
 			(Int32)(sampleRate));
 
+		if (unpackBlocks) {
+			alBufferi(m_bufferId, unpackAlignment, 0);
+		}
+		//looping sources play the intro once, then repeat the loop
+		if (m_loopEnd != 0 && alIsExtensionPresent("AL_SOFT_loop_points")) {
+			const Int32 points[2] = { (Int32)(m_loopStart), (Int32)(m_loopEnd) };
+			alBufferiv(m_bufferId, alGetEnumValue("AL_LOOP_POINTS_SOFT"), points);
+		}
+
+		m_sampleCount = sampleCount;
+		m_nchannels   = nchannels;
+		m_sampleRate  = sampleRate;
+		m_deviceBytes = nbytes;
+		m_evicted     = false;
 		m_length = TimeValue::FromSeconds(
-			(Float)m_sampleData.size() /
+			(Float)sampleCount /
 			(Float)sampleRate /
 			(Float)nchannels);
 
-		for (auto* soundPtr : soundsCopy) {
-			soundPtr->SetBuffer(this);
+		for (Sound* sound = m_firstSound; sound; sound = sound->m_nextSound) {
+			sound->AttachSource();
 		}
+		UpdateManaged();
 		return true;
 	}
 };
@@ -26,36 +26,159 @@ namespace kz {
 
 
 
+	/** where the samples of a SoundBuffer are held once uploaded*/
+	enum SAMPLERESIDENCY {
+		SAMPLERESIDENCY_CPU,    //a copy is kept beside the device's (default)
+		SAMPLERESIDENCY_DEVICE  //only the device keeps the samples
+	};
+
+
+
 	/**
     source data used by Sounds*/
-	class SoundBuffer final {
+	class SoundBuffer final : public Allocated {
 	public:
 		SoundBuffer();
 		SoundBuffer(const SoundBuffer& copy);
 		SoundBuffer& operator=(const SoundBuffer& copy);
+
+		/** take over the samples and device buffer of another buffer,
+			without uploading them again. its sounds and ResidencyManager
+			follow the samples. the moved-from buffer is left empty.*/
+		SoundBuffer(SoundBuffer&& other) noexcept;
+		SoundBuffer& operator=(SoundBuffer&& other) noexcept;
 		~SoundBuffer();
 
-		/** load the sound data from a file.
+		/** load the sound data from a file. 16-bit pcm files that can
+			be mapped are uploaded in place and stay mapped, instead of
+			being copied into a sample array. other files are decoded
+			once into the cache set by SetAudioCacheDirectory, if any.
 			@param filename: name of the file to load
 			@return: true on success, false on failure*/
 		Bool Load(const String& filename);
 
-		/** get information about the sound resource
+		/** load the sound data from an encoded file held in memory.
+			IMA4 and MS-ADPCM data stays compressed when the device
+			can play it, the same goes for files loaded from disk.
+			the data is only needed for the duration of the call.
+			@param data:   start of the encoded file contents
+			@param nbytes: size of the file contents in bytes
+			@return: true on success, false on failure*/
+		Bool Load(Lpcvoid data, SizeT nbytes);
+
+		/** load the sound data of a file whose contents were already read,
+			as by BatchLoader. the path is kept like Load(filename) does:
+			the decode cache is used, 16-bit pcm files are mapped and the
+			buffer can be reloaded from the path.
+			@param filename: name of the file the contents were read from
+			@param data:     start of the file contents, only read by this call
+			@param nbytes:   size of the file contents in bytes
+			@return: true on success, false on failure*/
+		Bool Load(const String& filename, Lpcvoid data, SizeT nbytes);
+
+		/** load the sound data from an encoded file held in memory that
+			outlives the buffer, such as an entry of an AudioPack. the data
+			is not copied, the samples are decoded from it again when they
+			were freed or the buffer was evicted.
+			@param data:   start of the encoded file contents
+			@param nbytes: size of the file contents in bytes
+			@return: true on success, false on failure*/
+		Bool LoadMapped(Lpcvoid data, SizeT nbytes);
+
+		/** get information about the sound resource. samples is null
+			if they were freed after upload, see SetResidency
 			@param desc: structure to fill with data*/
 		Void GetDesc(AudioDesc* desc) const;
 
+		/** set where the samples are held after later loads. with
+			SAMPLERESIDENCY_DEVICE the cpu copy (or mapping) is freed once
+			uploaded; the file path, or a copy of the encoded data for
+			buffers loaded from memory (other than with LoadMapped), is
+			kept to decode it again.
+			@param residency: where to hold the samples*/
+		Void SetResidency(SAMPLERESIDENCY residency);
+
+		/** returns where the samples are held after upload*/
+		SAMPLERESIDENCY GetResidency() const;
+
+		/** decode the samples again if they were freed after upload,
+			they are kept until the next load
+			@return: false if they can not be decoded*/
+		Bool RestoreSamples();
+
+		/** get the memory held by the buffer
+			@param cpuBytes:    receives the bytes of samples, encoded
+			                    blocks or source data held by the buffer
+			@param deviceBytes: receives the bytes uploaded to the device*/
+		Void GetMemoryUsage(Uint64* cpuBytes, Uint64* deviceBytes) const;
+
+		/** returns true if a ResidencyManager unloaded the buffer, it is
+			loaded again when one of its sounds is played, even once the
+			buffer is no longer managed*/
+		Bool IsEvicted() const;
+
+		/** get the loop read from the file's metadata, see AudioFile
+			@param start: receives the first frame of the loop
+			@param end:   receives the frame after the last one of the loop
+			@return: false if the file defines no loop*/
+		Bool GetLoopPoints(Uint64* start, Uint64* end) const;
+
 
 	private:
+		friend class AsyncLoader;
+		friend class ResidencyManager;
 		friend class Sound;
-		typedef std::unordered_set<Sound*> SOUNDSET;
 
+		/** buffer without a device buffer, decoded into off the main
+			thread and handed over with Adopt*/
+		struct Staging {};
+		explicit SoundBuffer(Staging);
+		Bool Adopt(SoundBuffer& staging, const String& filename, const AudioDesc& desc);
+
+		Bool DecodeFile(const String& filename, AudioDesc* desc,
+			Lpcvoid data = NULL, SizeT nbytes = 0);
 		Bool Initialize(AudioFile* file);
+		Bool Decode(AudioFile* file, const AudioDesc& desc);
+		Void SetDirect(AudioFile* file);
+		Bool DecodeSegments(AudioFile* file, const AudioDesc& desc);
 		Bool Update(Uint32 channels, Uint32 sampleRate);
+		Void ReleaseData();
+		Void ReleaseSamples();
+		Void ReleaseSource();
+		Bool Evict();
+		Bool Reload();
+		Bool DecodeSource();
+		Void UpdateManaged();
+		Bool IsInUse() const;
+		Void Swap(SoundBuffer& other) noexcept;
+		const Int16* GetSamples(SizeT* count) const;
 
-		SAMPLEDATA       m_sampleData;
-		TimeValue        m_length;
-		Uint32           m_bufferId;
-		mutable SOUNDSET m_registeredSounds;
+		SAMPLERESIDENCY   m_residency;
+		String            m_sourcePath;  //file the samples are decoded from
+		BYTEDATA          m_sourceData;  //or its contents, if loaded from memory
+		const Byte*       m_sourceView;  //or contents outliving the buffer
+		SizeT             m_sourceSize;  //size of m_sourceView
+		Uint64            m_sampleCount; //samples uploaded to the device
+		SAMPLEDATA        m_sampleData;
+		AudioFile*        m_directFile;
+		BYTEDATA          m_encodedData;
+		AUDIOENCODING     m_encoding;
+		Uint32            m_framesPerBlock;
+		Uint64            m_encodedSamples;
+		Uint64            m_loopStart;
+		Uint64            m_loopEnd;
+		Uint32            m_nchannels;   //format of the last upload
+		Uint32            m_sampleRate;
+		Uint64            m_deviceBytes; //bytes of the last upload
+		Bool              m_evicted;
+		ResidencyManager* m_manager;
+		SoundBuffer*      m_prevManaged; //other buffers of m_manager
+		SoundBuffer*      m_nextManaged;
+		Uint64            m_managedBytes; //bytes counted by m_manager
+		TimeValue         m_length;
+		Uint32            m_bufferId;
+		mutable Sound*    m_firstSound;  //sounds using the buffer, see Sound
+		Bool              m_serial;      //decode on the calling thread only
 	};
 };
 /*****************************************************************************/  
@@ -0,0 +1,86 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzthreadpool.cpp											          |
+| Desc: fixed set of worker threads running queued tasks                      |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#include "kzthreadpool.h"
+namespace kz {
+
+
+
+	ThreadPool::ThreadPool(Uint32 nthreads) {
+		m_quit = false;
+		if (nthreads == 0) {
+			nthreads = Max<Uint32>(std::thread::hardware_concurrency(), 1);
+		}
+		for (Uint32 i = 0; i < nthreads; ++i) {
+			m_threads.push_back(std::thread(&ThreadPool::Run, this));
+		}
+	}
+
+
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_wakeup.notify_all();
+		for (auto& thread : m_threads) {
+			thread.join();
+		}
+	}
+
+
+
+	Void ThreadPool::Submit(TASK task) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_tasks.push_back(std::move(task));
+		}
+		m_wakeup.notify_one();
+	}
+
+
+
+	Uint32 ThreadPool::GetThreadCount() const {
+		return (Uint32)(m_threads.size());
+	}
+
+
+
+	Void ThreadPool::Run() {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;) {
+			if (!m_tasks.empty()) {
+				TASK task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+				lock.unlock();
+				task();
+				lock.lock();
+			}
+			else if (m_quit) {
+				break;
+			}
+			else m_wakeup.wait(lock);
+		}
+	}
+};
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/
@@ -0,0 +1,70 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzthreadpool.h												          |
+| Desc: fixed set of worker threads running queued tasks                      |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#ifndef __KZTHREADPOOL_H__
+#define __KZTHREADPOOL_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "kzbasetypes.h"
+#include "kznoncopyable.h"
+namespace kz {
+
+
+
+	/**
+	fixed set of worker threads running queued tasks in submission order.
+	tasks still queued when the pool is destroyed are run before the
+	workers exit.*/
+	class ThreadPool final : NonCopyable {
+	public:
+		typedef std::function<Void()> TASK;
+
+		/**	start the worker threads
+			@param nthreads: number of workers, zero picks one per core*/
+		explicit ThreadPool(Uint32 nthreads = 0);
+		~ThreadPool();
+
+
+		/** queue a task to run on one of the workers*/
+		Void Submit(TASK task);
+
+
+		/** returns the number of worker threads*/
+		Uint32 GetThreadCount() const;
+
+
+	private:
+		Void Run();
+
+		std::vector<std::thread> m_threads;
+		std::deque<TASK>         m_tasks;
+		std::mutex               m_mutex;
+		std::condition_variable  m_wakeup;
+		Bool                     m_quit;
+	};
+};
+/*****************************************************************************/
+#endif//EOF                                                                   |
+/*****************************************************************************/
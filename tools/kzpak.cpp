@@ -0,0 +1,55 @@
+/*****************************************************************************\
+| Copyright(C) 2019-2024 KZGAMES. All Rights Reserved.                        |
+| Author: Zachary T Harris                                                    |
+| 																			  |
+| File: kzpak.cpp													          |
+| Desc: command line tool that builds packed audio archives (.kzpak)          |
+|       build alongside kzaudio, e.g.                                         |
+|       c++ -std=c++11 -Ikzaudio tools/kzpak.cpp kzaudio/kzaudiopack.cpp      |
+|           kzaudio/kziobuf.cpp kzaudio/kziostream.cpp -o kzpak               |
+|     																		  |
+| This program is free software: you can redistribute it and/or modify		  |
+| it under the terms of the GNU General Public License as published by		  |
+| the Free Software Foundation, either version 3 of the License, or			  |
+| (at your option) any later version.										  |
+| 																			  |
+| This program is distributed in the hope that it will be useful,			  |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of			  |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the				  |
+| GNU General Public License for more details.								  |
+| 																			  |
+| You should have received a copy of the GNU General Public License			  |
+| along with this program.  If not, see <http://www.gnu.org/licenses/>.		  |
+******************************************************************************/
+#include <iostream>
+#include "kzaudiopack.h"
+
+
+
+int main(int argc, char** argv) {
+	if (argc < 4) {
+		std::cout << "usage: kzpak <output.kzpak> <directory> <file> [file...]\n"
+		          << "  packs each file read from <directory>, looked up by\n"
+		          << "  its name relative to <directory>" << std::endl;
+		return 1;
+	}
+	kz::AudioPackWriter writer;
+	std::string         directory = argv[2];
+
+	if (!directory.empty() &&
+		directory.back() != '/' && directory.back() != '\\') {
+		directory += '/';
+	}
+	for (int i = 3; i < argc; ++i) {
+		writer.AddFile(argv[i], directory + argv[i]);
+	}
+	if (!writer.Write(argv[1])) {
+		std::cout << "failed to write " << argv[1] << std::endl;
+		return 1;
+	}
+	std::cout << "packed " << (argc - 3) << " files into " << argv[1] << std::endl;
+	return 0;
+}
+/*****************************************************************************/
+//EOF                                                                         |
+/*****************************************************************************/